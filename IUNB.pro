@@ -12,18 +12,19 @@ TARGET = IUNB
 TEMPLATE = app
 
 
+include(engine.pri)
+
 SOURCES += \
     src/main.cpp \
     src/iunb.cpp \
-    src/log_pass.cpp
+    src/log_pass.cpp \
+    src/book_list.cpp
 
 HEADERS  += \
     src/iunb.h \
-    src/log_pass.h
+    src/log_pass.h \
+    src/book_list.h
 
 FORMS    += \
     src/iunb.ui \
     src/log_pass.ui
-
-INCLUDEPATH += D:\Code\boost_1_54_0
-LIBS += -LD:\Code\boost_1_54_0\stage\lib
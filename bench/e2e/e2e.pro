@@ -0,0 +1,48 @@
+#-------------------------------------------------
+#
+# End-to-end benchmark of unread and book info requests
+# Run it against tools/replay, not against the site
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = e2e
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+    main.cpp \
+    ../../src/http_reply.cpp \
+    ../../src/body_decoder.cpp \
+    ../../src/conn_pool.cpp \
+    ../../src/dns_cache.cpp \
+    ../../src/task_pool.cpp \
+    ../../src/cancel_token.cpp \
+    ../../src/unread_parser.cpp \
+    ../../src/tag_index.cpp \
+    ../../src/descr_parser.cpp \
+    ../../src/settings.cpp \
+    ../../src/scan.cpp
+
+HEADERS  += \
+    ../../src/http_reply.h \
+    ../../src/body_decoder.h \
+    ../../src/conn_pool.h \
+    ../../src/dns_cache.h \
+    ../../src/task_pool.h \
+    ../../src/cancel_token.h \
+    ../../src/unread_parser.h \
+    ../../src/tag_index.h \
+    ../../src/descr_parser.h \
+    ../../src/settings.h \
+    ../../src/scan.h
+
+INCLUDEPATH += ../../src
+
+INCLUDEPATH += D:\Code\boost_1_54_0
+LIBS += -LD:\Code\boost_1_54_0\stage\lib
+
+INCLUDEPATH += D:\Code\zlib-1.2.8
+LIBS += -LD:\Code\zlib-1.2.8 -lzlib
@@ -0,0 +1,173 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Request code paths of IUNB
+#include "http_reply.h"
+#include "conn_pool.h"
+#include "dns_cache.h"
+#include "task_pool.h"
+#include "cancel_token.h"
+#include "unread_parser.h"
+#include "descr_parser.h"
+#include "scan.h"
+#include "settings.h"
+
+// Output
+#include <iostream>
+// Latencies
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cstdlib>
+
+// Request templates from pref.xml
+#include <boost/property_tree/xml_parser.hpp>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Benchmark
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    typedef std::chrono::steady_clock clock;
+
+    // Latency of every request of one kind
+    typedef std::vector<clock::duration> latencies;
+
+    double ms(clock::duration d)
+    {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    // Requests per second, p50 and p99 latency
+    void report(const char *name, latencies &values, clock::duration total)
+    {
+        if (values.empty())
+        {
+            std::cout << name << ": no requests\n";
+            return;
+        }
+        std::sort(values.begin(), values.end());
+        const double seconds =
+                std::chrono::duration<double>(total).count();
+        std::cout << name << ": " << values.size() << " in "
+                  << seconds << " s, " << values.size()/seconds << "/s, "
+                  << "p50 " << ms(values[(values.size()-1)/2]) << " ms, "
+                  << "p99 " << ms(values[(values.size()-1)*99/100]) << " ms"
+                  << std::endl;
+    }
+} // !namespace
+
+// !Benchmark
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Usage: e2e host port [pages] [books] [threads] [pref.xml]
+// Listing pages are fetched one by one, like get_unread with parallel 1,
+// then found books are fetched by threads, like prefetch does
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: e2e host port [pages=10] [books=100] "
+                     "[threads=4] [pref=./rsrc/.pref.xml]" << std::endl;
+        return 1;
+    }
+
+    const std::string host = argv[1];
+    const std::string port = argv[2];
+    const size_t pages = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10;
+    const size_t books = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 100;
+    size_t threads = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 4;
+    if (!threads) threads = 1;
+
+    try
+    {
+        boost::property_tree::ptree pref;
+        boost::property_tree::read_xml(argc > 6 ? argv[6] : "./rsrc/.pref.xml",
+                                       pref);
+        const settings cfg(pref);
+
+        boost::asio::io_service io_service;
+        dns_cache dns(io_service);
+        conn_pool conns(io_service, dns);
+        conns.set_limits(threads, std::chrono::seconds(60));
+        task_pool tasks(io_service);
+        tasks.start(threads);
+
+        std::cout << "Scan kernels: " << scan::kernel_name() << std::endl;
+
+        // Listing pages
+        size_t page_num = cfg.unread.start_page;
+
+        std::vector<unsigned long long> ids;
+        unread_parser parser([&ids](unsigned long long id,
+                                    const char *, size_t)
+        {
+            ids.push_back(id);
+        });
+        http_reply reply([&parser](const char *data, size_t size)
+        {
+            parser.feed(data, size);
+        });
+
+        latencies page_times;
+        std::string req;
+        const clock::time_point pages_start = clock::now();
+        for (size_t i = 0; i < pages; ++i)
+        {
+            cfg.unread.get.render(req, {"Cookie:", decimal(page_num++).str()});
+            parser.reset();
+            reply.reset();
+
+            const clock::time_point start = clock::now();
+            http_request(conns, host, port, req, reply);
+            page_times.push_back(clock::now() - start);
+        }
+        report("Pages", page_times, clock::now() - pages_start);
+
+        if (ids.empty())
+        {
+            std::cout << "Books: no books found in pages" << std::endl;
+            return 0;
+        }
+
+        // Book pages, ids are repeated if there are few of them
+        std::vector<std::future<clock::duration>> results;
+        const clock::time_point books_start = clock::now();
+        for (size_t i = 0; i < books; ++i)
+        {
+            cfg.book_info.get.render(req, {decimal(ids[i%ids.size()]).str()});
+            results.emplace_back(tasks.submit([&conns, &host, &port, req]()
+            {
+                std::string buf;
+                http_reply reply([&buf](const char *data, size_t size)
+                {
+                    buf.append(data, size);
+                });
+
+                const clock::time_point start = clock::now();
+                http_request(conns, host, port, req, reply);
+                tag_index index;
+                book_descr descr;
+                parse_for_descr(buf, index, descr);
+                return clock::now() - start;
+            }));
+        }
+
+        latencies book_times;
+        for (auto &result : results) book_times.push_back(tasks.get(result));
+        report("Books", book_times, clock::now() - books_start);
+
+        tasks.stop();
+    }
+    catch (std::exception &ref)
+    {
+        std::cerr << ref.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,487 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Parsers of IUNB
+#include "http_reply.h"
+#include "unread_parser.h"
+#include "descr_parser.h"
+#include "scan.h"
+
+// Output, fixtures and baseline
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+// Results by name
+#include <map>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+// Allocation counter
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Machine of baseline
+#ifndef _WIN32
+#include <sys/utsname.h>
+#endif
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Allocation counter
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    std::atomic<size_t> allocations(0);
+} // !namespace
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) throw()
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+    std::free(p);
+}
+
+// Sized versions are called since C++14, they must match the above
+void operator delete(void *p, size_t) throw()
+{
+    operator delete(p);
+}
+
+void operator delete[](void *p, size_t) throw()
+{
+    operator delete[](p);
+}
+
+// !Allocation counter
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Pages
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    typedef std::chrono::steady_clock clock;
+
+    // What get_unread gets from socket: read_some returns a packet
+    // or a full 16 KB buffer, 0 - the whole reply at once
+    const size_t arrivals[] = { 1460, 16*1024, 0 };
+
+    // Listing with books, half of them rated
+    std::string make_listing(size_t books)
+    {
+        std::string page = "<html><head><title>Rating</title>"
+                           "<script>var a = '<a href=\"x\">';</script>"
+                           "</head><body><div class=\"list\">\n";
+        for (size_t i = 0; i < books; ++i)
+        {
+            page += "<div class=\"item\"><div class=\"cover\">"
+                    "<img src=\"http://img.imhonet.ru/cover.jpg\"></div>"
+                    "<a href=\"http://books.imhonet.ru/element/";
+            page += std::to_string(100000+i*7);
+            page += "/\" class=\"title\"> Название книги номер ";
+            page += std::to_string(i);
+            page += " </a><div class=\"rate\" data-rate=\"";
+            if (i%2) page += std::to_string(i%10+1);
+            page += "\"></div></div>\n";
+        }
+        page += "</div></body></html>";
+        return page;
+    }
+
+    // Description page with summary of summary_size bytes
+    std::string make_descr(size_t summary_size)
+    {
+        std::string page = "<html><head><title>Book</title></head><body>"
+                           "<div class=\"menu\"><ul>";
+        for (size_t i = 0; i < 50; ++i)
+        {
+            page += "<li><a href=\"/menu/" + std::to_string(i) +
+                    "/\">Menu</a></li>";
+        }
+        page += "</ul></div><div class=\"hreview-aggregate\">"
+                "<span class=\"fn\">Название книги</span>"
+                "<span class=\"rating\"><span class=\"average\">7.5</span>"
+                "<span class=\"votes\">1234</span></span>"
+                "<p class=\"summary\">";
+        while (page.size() < summary_size) page += "Описание книги. <br>";
+        page += "</p></div><div data-content=\"Похожие книги\">"
+                "<span class=\"fn\">Другая книга</span></div></body></html>";
+        return page;
+    }
+
+    // Reply as the site sends it, with chunked body
+    std::string make_reply(const std::string &body)
+    {
+        std::ostringstream reply;
+        reply << "HTTP/1.1 200 OK\r\n"
+                 "Content-Type: text/html; charset=utf-8\r\n"
+                 "Transfer-Encoding: chunked\r\n\r\n";
+        for (size_t pos = 0; pos < body.size(); pos += 8192)
+        {
+            const size_t size = std::min<size_t>(8192, body.size()-pos);
+            reply << std::hex << size << "\r\n";
+            reply.write(body.data()+pos, size);
+            reply << "\r\n";
+        }
+        reply << "0\r\n\r\n";
+        return reply.str();
+    }
+
+    // Body of recorded reply
+    std::string reply_body(const std::string &raw)
+    {
+        std::string body;
+        http_reply reply([&body](const char *data, size_t size)
+        {
+            body.append(data, size);
+        });
+        reply.consume(raw.data(), raw.size());
+        reply.finish();
+        return body;
+    }
+} // !namespace
+
+// !Pages
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Benchmark
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Rate is in units of run: bytes of page or find_by_tag calls
+    struct result
+    {
+        double per_sec;
+        double allocs_per_page;
+        const char *unit;
+    };
+
+    // Baseline and machine, where it was made
+    struct baseline
+    {
+        std::string machine;
+        std::map<std::string, result> results;
+    };
+
+    typedef std::map<std::string, result> result_map;
+
+    // Run f on page in rounds, the best round is taken,
+    // so the result doesn't depend on other processes much
+    // f does units of work per run, bytes by default
+    result measure(size_t units, const std::function<void ()> &f,
+                   const char *unit = "B")
+    {
+        // Warm up caches and kernel choice
+        f();
+
+        result res = { 0, 0, unit };
+        size_t total_runs = 0;
+        const size_t allocs_start = allocations;
+        for (size_t round = 0; round < 7; ++round)
+        {
+            size_t runs = 0;
+            const clock::time_point start = clock::now();
+            clock::duration passed;
+            do
+            {
+                f();
+                ++runs;
+                passed = clock::now() - start;
+            }
+            while (passed < std::chrono::milliseconds(30));
+
+            const double rate = units*runs /
+                    std::chrono::duration<double>(passed).count();
+            if (rate > res.per_sec) res.per_sec = rate;
+            total_runs += runs;
+        }
+        res.allocs_per_page = double(allocations - allocs_start)/total_runs;
+        return res;
+    }
+
+    // Listing through http_reply in pieces, like get_unread does
+    void bench_listing(const std::string &name, const std::string &raw,
+                       result_map &out_results)
+    {
+        size_t books = 0;
+        unread_parser parser([&books](unsigned long long,
+                                      const char *, size_t)
+        {
+            ++books;
+        });
+        http_reply reply([&parser](const char *data, size_t size)
+        {
+            parser.feed(data, size);
+        });
+
+        for (size_t arrival : arrivals)
+        {
+            const size_t piece = arrival ? arrival : raw.size();
+            const std::string full_name = name + "/" +
+                    (arrival ? std::to_string(arrival) : "whole");
+            out_results[full_name] = measure(raw.size(), [&]()
+            {
+                parser.reset();
+                reply.reset();
+                for (size_t pos = 0; pos < raw.size(); pos += piece)
+                {
+                    reply.consume(raw.data()+pos,
+                                  std::min(piece, raw.size()-pos));
+                }
+            });
+        }
+    }
+
+    // Description is parsed from the whole page, like get_book_info does
+    void bench_descr(const std::string &name, const std::string &page,
+                     result_map &out_results)
+    {
+        // Index is reused between pages, like in pooled buffers
+        tag_index index;
+        book_descr descr;
+        std::string html;
+        out_results[name + "/parse_for_descr"] = measure(page.size(), [&]()
+        {
+            parse_for_descr(page, index, descr);
+            format_descr(descr, "1", html);
+        });
+
+        // find_by_tag alone on the built index
+        // It doesn't read the page, so it is timed per call
+        index.build(page.data(), page.data()+page.size());
+        out_results[name + "/find_by_tag"] = measure(4, [&]()
+        {
+            size_t pos = 0;
+            descr.name = find_by_tag(index, "span", "fn", pos, 0);
+            descr.average = find_by_tag(index, "span", "average", pos, 0);
+            descr.votes = find_by_tag(index, "span", "votes", pos, 0);
+            descr.summary = find_by_tag(index, "p", "summary", pos, 1);
+        }, "call");
+    }
+
+    // Recorded replies from recorder's directory
+    void bench_recorded(const std::string &dir, result_map &out_results)
+    {
+        static const char similar[] = "data-content=\"Похожие книги\">";
+
+        std::ifstream index(dir + "/index.txt");
+        std::string line;
+        while (getline(index, line))
+        {
+            const std::string num = line.substr(0, line.find(' '));
+            std::ifstream file(dir + '/' + num + ".rsp", std::ios::binary);
+            if (!file) continue;
+            std::ostringstream raw;
+            raw << file.rdbuf();
+
+            // Kind of page by its content
+            const std::string body = reply_body(raw.str());
+            if (body.find(similar) != body.npos)
+                bench_descr("rec_" + num, body, out_results);
+            else
+                bench_listing("rec_" + num, raw.str(), out_results);
+        }
+    }
+
+    // CPU, OS and scan kernels, results of other machine aren't compared
+    std::string machine_name()
+    {
+        std::string cpu;
+        std::string os;
+#ifdef _WIN32
+        if (const char *id = std::getenv("PROCESSOR_IDENTIFIER")) cpu = id;
+        os = "Windows";
+#else
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (getline(cpuinfo, line))
+        {
+            if (line.compare(0, 10, "model name")) continue;
+            const size_t colon = line.find(": ");
+            if (colon != line.npos) cpu = line.substr(colon+2);
+            break;
+        }
+        utsname uts;
+        if (!uname(&uts)) os = std::string(uts.sysname) + ' ' + uts.release;
+#endif
+        if (cpu.empty()) cpu = "unknown cpu";
+        return cpu + " / " + os + " / scan kernels: " + scan::kernel_name();
+    }
+
+    // Baseline: "name per_sec allocs_per_page" lines
+    // and "# machine: " line
+    baseline load_baseline(const std::string &filename)
+    {
+        static const char machine[] = "# machine: ";
+
+        baseline base;
+        std::ifstream file(filename);
+        std::string line;
+        while (getline(file, line))
+        {
+            if (!line.compare(0, sizeof(machine)-1, machine))
+                base.machine = line.substr(sizeof(machine)-1);
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream in(line);
+            std::string name;
+            result res = { 0, 0, "" };
+            if (in >> name >> res.per_sec >> res.allocs_per_page)
+                base.results[name] = res;
+        }
+        return base;
+    }
+
+    bool save_baseline(const std::string &filename,
+                       const result_map &results)
+    {
+        std::ofstream file(filename, std::ios::trunc);
+        file << "# name per_sec allocs_per_page\n"
+             << "# per_sec is bytes of page, find_by_tag - calls\n"
+             << "# machine: " << machine_name() << '\n';
+        for (auto &i : results)
+        {
+            file << i.first << ' ' << std::fixed << std::setprecision(0)
+                 << i.second.per_sec << ' ' << std::setprecision(1)
+                 << i.second.allocs_per_page << '\n';
+        }
+        return static_cast<bool>(file);
+    }
+
+    // MB/s for pages, ns per call for lookups
+    std::string format_rate(const result &res)
+    {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1);
+        if (!strcmp(res.unit, "call")) out << 1e9/res.per_sec << " ns/call";
+        else out << res.per_sec/1e6 << " MB/s";
+        return out.str();
+    }
+} // !namespace
+
+// !Benchmark
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Usage: micro [-baseline file] [-fixtures dir] [-tolerance percent] [-save]
+// Throughput drop of more than tolerance (10% by default) or more
+// allocations than in baseline is a regression, then exit code is 2
+// Baseline of other machine isn't compared, save your own with -save
+int main(int argc, char *argv[])
+{
+    std::string baseline_file = "./bench/micro/baseline.txt";
+    std::string fixtures;
+    double tolerance = 0.1;
+    bool save = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-save")) save = true;
+        else if (!strcmp(argv[i], "-baseline") && i+1 < argc)
+            baseline_file = argv[++i];
+        else if (!strcmp(argv[i], "-fixtures") && i+1 < argc)
+            fixtures = argv[++i];
+        else if (!strcmp(argv[i], "-tolerance") && i+1 < argc)
+            tolerance = std::atof(argv[++i])/100;
+        else
+        {
+            std::cerr << "Usage: micro [-baseline file] [-fixtures dir] "
+                         "[-tolerance percent] [-save]" << std::endl;
+            return 1;
+        }
+    }
+
+    const std::string machine = machine_name();
+    std::cout << "Machine: " << machine << std::endl;
+
+    result_map results;
+    for (size_t books : { 20, 200, 2000 })
+    {
+        bench_listing("listing_" + std::to_string(books),
+                      make_reply(make_listing(books)), results);
+    }
+    for (size_t size : { 1024, 16*1024, 256*1024 })
+    {
+        bench_descr("descr_" + std::to_string(size/1024) + "k",
+                    make_descr(size), results);
+    }
+    if (fixtures.size()) bench_recorded(fixtures, results);
+
+    const baseline base = load_baseline(baseline_file);
+    const bool comparable = base.machine == machine;
+    if (!comparable && !save)
+    {
+        std::cout << "Baseline is made on other machine ("
+                  << (base.machine.empty() ? "unknown" : base.machine)
+                  << "), it isn't compared" << std::endl;
+    }
+    bool regression = false;
+
+    std::cout << std::left << std::setw(36) << "name"
+              << std::right << std::setw(14) << "rate"
+              << std::setw(10) << "change"
+              << std::setw(10) << "allocs"
+              << std::setw(10) << "was" << '\n';
+    for (auto &i : results)
+    {
+        const result &res = i.second;
+        std::cout << std::left << std::setw(36) << i.first << std::right
+                  << std::setw(14) << format_rate(res)
+                  << std::fixed << std::setprecision(1);
+
+        auto was = base.results.find(i.first);
+        if (!comparable || was == base.results.end())
+        {
+            std::cout << std::setw(10) << "-"
+                      << std::setw(10) << res.allocs_per_page
+                      << std::setw(10) << "-" << '\n';
+            continue;
+        }
+
+        const double change = res.per_sec/was->second.per_sec - 1;
+        const bool slower = change < -tolerance ||
+                res.allocs_per_page > was->second.allocs_per_page + 0.5;
+        regression = regression || slower;
+        std::cout << std::setw(9) << std::showpos << change*100 << '%'
+                  << std::noshowpos
+                  << std::setw(10) << res.allocs_per_page
+                  << std::setw(10) << was->second.allocs_per_page
+                  << (slower ? "  REGRESSION" : "") << '\n';
+    }
+    std::cout.flush();
+
+    if (save)
+    {
+        if (!save_baseline(baseline_file, results))
+        {
+            std::cerr << "Can't write " << baseline_file << std::endl;
+            return 1;
+        }
+        std::cout << "Baseline saved to " << baseline_file << std::endl;
+        return 0;
+    }
+    return regression ? 2 : 0;
+}
@@ -0,0 +1,38 @@
+#-------------------------------------------------
+#
+# Benchmark of html parsers on synthetic and recorded pages
+# Run it from IUNB directory, so baseline is found
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = micro
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+    main.cpp \
+    ../../src/http_reply.cpp \
+    ../../src/body_decoder.cpp \
+    ../../src/unread_parser.cpp \
+    ../../src/tag_index.cpp \
+    ../../src/descr_parser.cpp \
+    ../../src/scan.cpp
+
+HEADERS  += \
+    ../../src/http_reply.h \
+    ../../src/body_decoder.h \
+    ../../src/unread_parser.h \
+    ../../src/tag_index.h \
+    ../../src/descr_parser.h \
+    ../../src/scan.h
+
+INCLUDEPATH += ../../src
+
+INCLUDEPATH += D:\Code\boost_1_54_0
+LIBS += -LD:\Code\boost_1_54_0\stage\lib
+
+INCLUDEPATH += D:\Code\zlib-1.2.8
+LIBS += -LD:\Code\zlib-1.2.8 -lzlib
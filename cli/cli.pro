@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# Command line IUNB: unread books to stdout or file
+# Run it from IUNB directory, so ./rsrc is found
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = iunb-cli
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../engine.pri)
+
+SOURCES += \
+    main.cpp
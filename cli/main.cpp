@@ -0,0 +1,161 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Networking, parsing and exclusion without GUI
+#include "engine.h"
+
+// Output
+#include <iostream>
+#include <fstream>
+// Descriptions are requested while listing is parsed
+#include <future>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Output
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Unread book and its description, if requested
+    struct book
+    {
+        unsigned long long id;
+        std::string title;
+        std::future<std::string> descr;
+    };
+
+    // Field without tabs and line breaks
+    std::string field(std::string text)
+    {
+        for (char &c : text)
+        {
+            if (c == '\t' || c == '\r' || c == '\n') c = ' ';
+        }
+        return text;
+    }
+
+    // id<TAB>title[<TAB>description]
+    void write_book(std::ostream &out, unsigned long long id,
+                    const std::string &title, const std::string *descr)
+    {
+        out << id << '\t' << field(title);
+        if (descr) out << '\t' << field(*descr);
+        out << '\n';
+    }
+} // !namespace
+
+// !Output
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Usage: iunb-cli [-login name -password pass] [-num N] [-descr] [-out file]
+// Settings and exclude lists are the same as in window: ./rsrc/$login.*
+// Unread books are written as they are found, one per line,
+// with descriptions they are written in listing order, when all are found
+int main(int argc, char *argv[])
+{
+    std::string login;
+    std::string password;
+    std::string out_filename;
+    size_t num = 0;
+    bool with_descr = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-login") && i+1 < argc) login = argv[++i];
+        else if (!strcmp(argv[i], "-password") && i+1 < argc)
+            password = argv[++i];
+        else if (!strcmp(argv[i], "-num") && i+1 < argc)
+            num = std::strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "-out") && i+1 < argc)
+            out_filename = argv[++i];
+        else if (!strcmp(argv[i], "-descr")) with_descr = true;
+        else
+        {
+            std::cerr << "Usage: iunb-cli [-login name -password pass] "
+                         "[-num N] [-descr] [-out file]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream out_file;
+    if (out_filename.size())
+    {
+        out_file.open(out_filename, std::ios::binary | std::ios::trunc);
+        if (!out_file)
+        {
+            std::cerr << "Can't write " << out_filename << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = out_filename.size() ? out_file : std::cout;
+
+    try
+    {
+        engine core;
+        core.load_settings(login);
+
+        if (login.size())
+        {
+            core.set_cookie(core.authorize(login, password,
+                                           core.new_task_token()));
+        }
+
+        cancel_token::ptoken token = core.new_task_token();
+        std::vector<book> books;
+        core.get_unread(token, [&](unsigned long long id,
+                                   const char *title, size_t size)
+        {
+            if (!with_descr)
+            {
+                write_book(out, id, std::string(title, size), nullptr);
+                return;
+            }
+
+            // Description is requested at once, by worker thread
+            book b;
+            b.id = id;
+            b.title.assign(title, size);
+            b.descr = core.pool().submit([&core, id, token]()
+            {
+                std::string descr;
+                if (core.load_cached_info(id, descr))
+                {
+                    core.get_book_info(id, descr, token);
+                }
+                return descr;
+            });
+            books.push_back(std::move(b));
+        }, num);
+
+        for (book &b : books)
+        {
+            std::string descr;
+            try
+            {
+                descr = core.pool().get(b.descr);
+            }
+            catch (std::exception &ref)
+            {
+                std::cerr << "Description of " << b.id << ": "
+                          << ref.what() << std::endl;
+            }
+            write_book(out, b.id, b.title, &descr);
+        }
+        out.flush();
+
+        core.export_metrics();
+    }
+    catch (std::exception &ref)
+    {
+        std::cerr << ref.what() << std::endl;
+        return 1;
+    }
+    return out ? 0 : 1;
+}
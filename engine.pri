@@ -0,0 +1,58 @@
+#-------------------------------------------------
+#
+# Networking, parsing and exclusion without GUI
+# Included by IUNB.pro and cli/cli.pro
+#
+#-------------------------------------------------
+
+INCLUDEPATH += $$PWD/src
+
+SOURCES += \
+    $$PWD/src/engine.cpp \
+    $$PWD/src/settings.cpp \
+    $$PWD/src/http_reply.cpp \
+    $$PWD/src/body_decoder.cpp \
+    $$PWD/src/conn_pool.cpp \
+    $$PWD/src/dns_cache.cpp \
+    $$PWD/src/task_pool.cpp \
+    $$PWD/src/cancel_token.cpp \
+    $$PWD/src/unread_parser.cpp \
+    $$PWD/src/tag_index.cpp \
+    $$PWD/src/descr_parser.cpp \
+    $$PWD/src/descr_cache.cpp \
+    $$PWD/src/crawl_state.cpp \
+    $$PWD/src/buffer_pool.cpp \
+    $$PWD/src/excl_index.cpp \
+    $$PWD/src/list_writer.cpp \
+    $$PWD/src/logger.cpp \
+    $$PWD/src/metrics.cpp \
+    $$PWD/src/recorder.cpp \
+    $$PWD/src/scan.cpp
+
+HEADERS += \
+    $$PWD/src/engine.h \
+    $$PWD/src/settings.h \
+    $$PWD/src/http_reply.h \
+    $$PWD/src/body_decoder.h \
+    $$PWD/src/conn_pool.h \
+    $$PWD/src/dns_cache.h \
+    $$PWD/src/task_pool.h \
+    $$PWD/src/cancel_token.h \
+    $$PWD/src/unread_parser.h \
+    $$PWD/src/tag_index.h \
+    $$PWD/src/descr_parser.h \
+    $$PWD/src/descr_cache.h \
+    $$PWD/src/crawl_state.h \
+    $$PWD/src/buffer_pool.h \
+    $$PWD/src/excl_index.h \
+    $$PWD/src/list_writer.h \
+    $$PWD/src/logger.h \
+    $$PWD/src/metrics.h \
+    $$PWD/src/recorder.h \
+    $$PWD/src/scan.h
+
+INCLUDEPATH += D:\Code\boost_1_54_0
+LIBS += -LD:\Code\boost_1_54_0\stage\lib
+
+INCLUDEPATH += D:\Code\zlib-1.2.8
+LIBS += -LD:\Code\zlib-1.2.8 -lzlib
@@ -0,0 +1,160 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "body_decoder.h"
+
+// Inflate
+#include <zlib.h>
+
+// Name of encoding
+#include <boost/algorithm/string.hpp>
+
+// Broken compressed stream
+#include <stdexcept>
+#include <cstring>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Window bits of zlib
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Deflate with zlib header: RFC 1950
+    const int zlib_bits = MAX_WBITS;
+    // Deflate with gzip header: RFC 1952
+    const int gzip_bits = MAX_WBITS + 16;
+    // Deflate without header, some servers send it as "deflate"
+    const int raw_bits = -MAX_WBITS;
+
+    // Is this a zlib header: CM is deflate and FCHECK is right
+    bool is_zlib_head(const char *head)
+    {
+        const unsigned char cmf = static_cast<unsigned char>(head[0]);
+        const unsigned char flg = static_cast<unsigned char>(head[1]);
+        return (cmf & 0x0f) == Z_DEFLATED && (cmf*256 + flg) % 31 == 0;
+    }
+} // !namespace
+
+// !Window bits of zlib
+///////////////////////////////////////////////////////////////////////////////
+
+
+// body_decoder Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+body_decoder::body_decoder():
+    state(st_idle),
+    head_size(0)
+{
+} // !body_decoder::body_decoder()
+
+// Prepare for body with this Content-Encoding
+bool body_decoder::start(boost::string_ref content_encoding)
+{
+    if (boost::iequals(content_encoding, "gzip") ||
+        boost::iequals(content_encoding, "x-gzip"))
+    {
+        init(gzip_bits);
+        state = st_inflate;
+        return true;
+    }
+    if (boost::iequals(content_encoding, "deflate"))
+    {
+        // zlib or raw deflate is known from the first 2 bytes
+        head_size = 0;
+        state = st_sniff;
+        return true;
+    }
+    state = st_idle;
+    return false;
+} // !bool body_decoder::start(...)
+
+// Decode next piece of body and pass result to on_body
+void body_decoder::feed(const char *data, size_t size,
+                        const body_handler &on_body)
+{
+    if (state == st_sniff)
+    {
+        // Header may be split between pieces
+        while (head_size < 2 && size)
+        {
+            head[head_size++] = *data++;
+            --size;
+        }
+        if (head_size < 2) return;
+        init(is_zlib_head(head) ? zlib_bits : raw_bits);
+        state = st_inflate;
+        decode(head, head_size, on_body);
+    }
+
+    // Bytes after end of stream are ignored
+    if (state == st_inflate && size) decode(data, size, on_body);
+} // !void body_decoder::feed(...)
+
+// !body_decoder Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// body_decoder Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Start inflate with window bits (zlib, gzip or raw deflate)
+void body_decoder::init(int window_bits)
+{
+    if (stream)
+    {
+        // Inflate state of previous reply is reused
+        if (inflateReset2(stream.get(), window_bits) != Z_OK)
+            throw std::runtime_error("HTTP: Can't reset decoder");
+        return;
+    }
+
+    std::unique_ptr<z_stream_s, stream_end> new_stream(new z_stream_s);
+    std::memset(new_stream.get(), 0, sizeof(z_stream_s));
+    if (inflateInit2(new_stream.get(), window_bits) != Z_OK)
+    {
+        // Nothing to end
+        delete new_stream.release();
+        throw std::runtime_error("HTTP: Can't start decoder");
+    }
+    stream = std::move(new_stream);
+} // !void body_decoder::init(...)
+
+// Inflate data to out and pass it to on_body
+void body_decoder::decode(const char *data, size_t size,
+                          const body_handler &on_body)
+{
+    stream->next_in =
+            reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream->avail_in = static_cast<uInt>(size);
+
+    // Until input is used and out isn't full
+    do
+    {
+        stream->next_out = reinterpret_cast<Bytef*>(out);
+        stream->avail_out = sizeof(out);
+
+        int ret = ::inflate(stream.get(), Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) state = st_done;
+        else if (ret == Z_BUF_ERROR) break; // No progress, wait for input
+        else if (ret != Z_OK)
+            throw std::runtime_error("HTTP: Broken compressed body");
+
+        const size_t decoded = sizeof(out) - stream->avail_out;
+        if (decoded && on_body) on_body(out, decoded);
+    } while (state == st_inflate && (stream->avail_in || !stream->avail_out));
+} // !void body_decoder::decode(...)
+
+// zlib's stream deleter
+void body_decoder::stream_end::operator()(z_stream_s *stream) const
+{
+    inflateEnd(stream);
+    delete stream;
+} // !void body_decoder::stream_end::operator()(...) const
+
+// !body_decoder Private functions
+///////////////////////////////////////////////////////////////////////////////
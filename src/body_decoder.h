@@ -0,0 +1,90 @@
+#ifndef BODY_DECODER_H
+#define BODY_DECODER_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Decoded body is passed to user as it is inflated
+#include <functional>
+#include <memory>
+#include <string>
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Content-Encoding is a slice of reply's head
+#include <boost/utility/string_ref.hpp>
+
+#endif // Q_MOC_RUN
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// zlib's stream, zlib.h is included only by body_decoder.cpp
+struct z_stream_s;
+
+// Streaming decoder of Content-Encoding: gzip or deflate
+// Encoded body goes in piece by piece, decoded one goes out
+// through a fixed buffer, so whole body is never kept.
+// zlib state is kept between replies and only reset for the next one.
+class body_decoder
+{
+public:
+    typedef std::function<void (const char *data, size_t size)> body_handler;
+
+public:
+    body_decoder();
+
+    // Prepare for body with this Content-Encoding
+    // Return false if body isn't encoded or encoding is unknown,
+    // then body must be passed as is
+    bool start(boost::string_ref content_encoding);
+
+    // Decode next piece of body and pass result to on_body
+    // Throw if body is not a valid compressed stream
+    void feed(const char *data, size_t size, const body_handler &on_body);
+
+    // Whole compressed stream is decoded
+    bool finished() const { return state == st_done; }
+
+    // Decoding is started and not finished yet
+    bool active() const { return state != st_idle && state != st_done; }
+
+    // Stop decoding, next body is passed as is
+    void reset() { state = st_idle; }
+
+private:
+    // Start inflate with window bits (zlib, gzip or raw deflate)
+    void init(int window_bits);
+
+    // Inflate data to out and pass it to on_body
+    void decode(const char *data, size_t size, const body_handler &on_body);
+
+private:
+    enum decode_state
+    {
+        st_idle,    // Body isn't encoded
+        st_sniff,   // Deflate: waiting for 2 bytes to find zlib header
+        st_inflate, // Inflating
+        st_done     // End of compressed stream
+    };
+
+    // zlib's stream deleter
+    struct stream_end
+    {
+        void operator()(z_stream_s *stream) const;
+    };
+
+private:
+    std::unique_ptr<z_stream_s, stream_end> stream;
+    decode_state state;
+
+    // The first 2 bytes of deflate body
+    char head[2];
+    size_t head_size;
+
+    // Decoded piece for on_body
+    char out[16*1024];
+}; // !class body_decoder
+
+#endif // BODY_DECODER_H
@@ -0,0 +1,163 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "book_list.h"
+
+// Rows to remove are sorted
+#include <algorithm>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// book_list Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+book_list::book_list(QObject *parent):
+    QAbstractListModel(parent)
+{
+} // !book_list::book_list(...)
+
+//
+int book_list::rowCount(const QModelIndex &parent) const
+{
+    // List has no children
+    if (parent.isValid()) return 0;
+    return static_cast<int>(books.size());
+} // !int book_list::rowCount(...) const
+
+// Title for display, id for Qt::UserRole
+QVariant book_list::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() ||
+        index.row() >= static_cast<int>(books.size())) return QVariant();
+
+    const book &b = books[index.row()];
+    if (role == Qt::DisplayRole) return b.title;
+    if (role == Qt::UserRole) return QVariant(b.id);
+    return QVariant();
+} // !QVariant book_list::data(...) const
+
+// Row of book, -1 if it isn't in list
+int book_list::row_of(unsigned long long id) const
+{
+    auto found = rows.find(id);
+    return found == rows.end() ? -1 : found->second;
+} // !int book_list::row_of(...) const
+
+// Add books to the end with one insert
+void book_list::append(std::vector<book> &batch)
+{
+    // Book found on two pages, or in list already, is added once
+    const int first = static_cast<int>(books.size());
+    size_t added = 0;
+    for (book &b : batch)
+    {
+        if (!rows.emplace(b.id, first + static_cast<int>(added)).second)
+            continue;
+        if (&batch[added] != &b) batch[added] = std::move(b);
+        ++added;
+    }
+    batch.resize(added);
+    if (batch.empty()) return;
+
+    beginInsertRows(QModelIndex(), first,
+                    first + static_cast<int>(batch.size()) - 1);
+    books.reserve(books.size() + batch.size());
+    for (book &b : batch) books.push_back(std::move(b));
+    endInsertRows();
+    batch.clear();
+} // !void book_list::append(...)
+
+// Remove rows, scattered rows are removed in one pass
+void book_list::remove(std::vector<int> rows_to_remove)
+{
+    if (rows_to_remove.empty()) return;
+
+    std::sort(rows_to_remove.begin(), rows_to_remove.end());
+    rows_to_remove.erase(std::unique(rows_to_remove.begin(),
+                                     rows_to_remove.end()),
+                         rows_to_remove.end());
+
+    const int first = rows_to_remove.front();
+    const int last = rows_to_remove.back();
+
+    // One run of neighbour rows [first, last] is removed at once
+    if (last - first + 1 == static_cast<int>(rows_to_remove.size()))
+    {
+        beginRemoveRows(QModelIndex(), first, last);
+        for (int row = first; row <= last; ++row) rows.erase(books[row].id);
+        books.erase(books.begin()+first, books.begin()+last+1);
+        endRemoveRows();
+        reindex(first);
+        return;
+    }
+
+    // Many runs: books are moved once and view is notified once,
+    // not for every run
+    emit layoutAboutToBeChanged();
+
+    // Views keep their current and selected rows, removed ones are gone
+    const QModelIndexList old_indexes = persistentIndexList();
+    QModelIndexList new_indexes;
+    for (const QModelIndex &i : old_indexes)
+    {
+        auto above = std::lower_bound(rows_to_remove.begin(),
+                                      rows_to_remove.end(), i.row());
+        if (above != rows_to_remove.end() && *above == i.row())
+        {
+            new_indexes.append(QModelIndex());
+            continue;
+        }
+        const int removed = static_cast<int>(above - rows_to_remove.begin());
+        new_indexes.append(index(i.row() - removed, i.column()));
+    }
+
+    // Compact books from the first removed row
+    size_t out = first;
+    auto next = rows_to_remove.begin();
+    for (size_t row = first; row < books.size(); ++row)
+    {
+        if (next != rows_to_remove.end() && *next == static_cast<int>(row))
+        {
+            rows.erase(books[row].id);
+            ++next;
+            continue;
+        }
+        books[out++] = std::move(books[row]);
+    }
+    books.erase(books.begin()+out, books.end());
+    reindex(first);
+
+    changePersistentIndexList(old_indexes, new_indexes);
+    emit layoutChanged();
+} // !void book_list::remove(...)
+
+// Remove all books
+void book_list::clear()
+{
+    beginResetModel();
+    books.clear();
+    rows.clear();
+    endResetModel();
+} // !void book_list::clear()
+
+// !book_list Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// book_list Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Update rows of books from row to the end
+void book_list::reindex(size_t from)
+{
+    for (size_t row = from; row < books.size(); ++row)
+    {
+        rows[books[row].id] = static_cast<int>(row);
+    }
+} // !void book_list::reindex(...)
+
+// !book_list Private functions
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,72 @@
+#ifndef BOOK_LIST_H
+#define BOOK_LIST_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QAbstractListModel>
+
+// Books in one array, rows of them by id
+#include <vector>
+#include <unordered_map>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Unread books for list view
+// Books are kept in one array and added or removed by batches,
+// so view is updated once for thousands of books.
+// Used by GUI thread only.
+class book_list : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    struct book
+    {
+        book(): id(0), loading(false) {}
+
+        // Book's id
+        unsigned long long id;
+        // Book's title, shown in list
+        QString title;
+        // Book's description, null if not loaded yet
+        QString descr;
+        // Description is requested and not received yet
+        bool loading;
+    };
+
+public:
+    explicit book_list(QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    book &at(int row) { return books[row]; }
+
+    // Row of book, -1 if it isn't in list
+    int row_of(unsigned long long id) const;
+
+    // Add books to the end with one insert
+    // Books already in list are skipped, so every id has one row
+    void append(std::vector<book> &batch);
+
+    // Remove rows, one run of neighbour rows is removed by rows,
+    // scattered rows by one pass over books with one layout change
+    void remove(std::vector<int> rows_to_remove);
+
+    // Remove all books
+    void clear();
+
+private:
+    // Update rows of books from row to the end
+    void reindex(size_t from);
+
+private:
+    std::vector<book> books;
+
+    // Book's id - row, ids are unique in list
+    std::unordered_map<unsigned long long, int> rows;
+}; // !class book_list
+
+#endif // BOOK_LIST_H
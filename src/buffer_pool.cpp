@@ -0,0 +1,130 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "buffer_pool.h"
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// buffer_pool::buffers Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Reply appends body to body
+buffer_pool::buffers::buffers():
+    reply([this](const char *data, size_t size)
+    {
+        body.append(data, size);
+    })
+{
+} // !buffer_pool::buffers::buffers()
+
+// Forget contents, keep capacity
+void buffer_pool::buffers::clear()
+{
+    request.clear();
+    body.clear();
+    reply.reset();
+    index.clear();
+} // !void buffer_pool::buffers::clear()
+
+// !buffer_pool::buffers Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// buffer_pool::lease Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+buffer_pool::lease::lease(lease &&ref):
+    pool(ref.pool),
+    buf(std::move(ref.buf))
+{
+    ref.pool = nullptr;
+} // !buffer_pool::lease::lease(...)
+
+//
+buffer_pool::lease &buffer_pool::lease::operator=(lease &&ref)
+{
+    if (this != &ref)
+    {
+        // Return own buffers first
+        if (pool) pool->put(std::move(buf));
+        pool = ref.pool;
+        buf = std::move(ref.buf);
+        ref.pool = nullptr;
+    }
+    return *this;
+} // !buffer_pool::lease &buffer_pool::lease::operator=(...)
+
+//
+buffer_pool::lease::~lease()
+{
+    if (pool) pool->put(std::move(buf));
+} // !buffer_pool::lease::~lease()
+
+// !buffer_pool::lease Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// buffer_pool::lease Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+buffer_pool::lease::lease(buffer_pool *pool, std::unique_ptr<buffers> buf):
+    pool(pool),
+    buf(std::move(buf))
+{
+} // !buffer_pool::lease::lease(...)
+
+// !buffer_pool::lease Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// buffer_pool Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+buffer_pool::buffer_pool(size_t max_idle, size_t max_capacity):
+    max_idle(max_idle),
+    max_capacity(max_capacity)
+{
+} // !buffer_pool::buffer_pool(...)
+
+// Get idle buffers, cleared, or new ones
+buffer_pool::lease buffer_pool::get()
+{
+    std::unique_ptr<buffers> buf;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idle.size())
+        {
+            buf = std::move(idle.back());
+            idle.pop_back();
+        }
+    }
+    if (!buf) buf.reset(new buffers);
+    return lease(this, std::move(buf));
+} // !buffer_pool::lease buffer_pool::get()
+
+// !buffer_pool Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// buffer_pool Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Return buffers from lease
+void buffer_pool::put(std::unique_ptr<buffers> buf)
+{
+    // Buffers of a huge page would be kept forever
+    if (!buf || buf->capacity() > max_capacity) return;
+
+    // Cleared out of lock, next get() takes them as is
+    buf->clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idle.size() < max_idle) idle.push_back(std::move(buf));
+} // !void buffer_pool::put(...)
+
+// !buffer_pool Private functions
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,99 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Buffers are shared between worker threads
+#include <mutex>
+// Idle buffers
+#include <vector>
+#include <memory>
+#include <string>
+
+// Reply of request is read into buffers
+#include "http_reply.h"
+// Index of page in buffers
+#include "tag_index.h"
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Buffers of requests, reused by the next requests
+// Request, body, reply's head and page index keep their capacity,
+// so request of the usual size does no heap allocation.
+class buffer_pool
+{
+public:
+    // Buffers of one request
+    class buffers
+    {
+    public:
+        // Reply appends body to body
+        buffers();
+
+        // Forget contents, keep capacity
+        void clear();
+
+        // Memory taken by buffers
+        size_t capacity() const
+        { return request.capacity() + body.capacity(); }
+
+        std::string request;
+        std::string body;
+        http_reply reply;
+        tag_index index;
+
+    private:
+        // Reply refers to this body
+        buffers(const buffers &);
+        buffers &operator=(const buffers &);
+    }; // !class buffers
+
+    // Borrowed buffers
+    // They go back to pool on destruction
+    class lease
+    {
+    public:
+        lease(): pool(nullptr) {}
+        lease(lease &&ref);
+        lease &operator=(lease &&ref);
+        ~lease();
+
+        buffers &operator*() const { return *buf; }
+        buffers *operator->() const { return buf.get(); }
+
+    private:
+        friend class buffer_pool;
+        lease(buffer_pool *pool, std::unique_ptr<buffers> buf);
+        lease(const lease &);
+        lease &operator=(const lease &);
+
+    private:
+        buffer_pool *pool;
+        std::unique_ptr<buffers> buf;
+    }; // !class lease
+
+public:
+    // Keep up to max_idle buffers, bigger than max_capacity are freed
+    explicit buffer_pool(size_t max_idle = 16,
+                         size_t max_capacity = 4 << 20);
+
+    // Get idle buffers, cleared, or new ones
+    lease get();
+
+private:
+    // Return buffers from lease
+    void put(std::unique_ptr<buffers> buf);
+
+private:
+    std::mutex mutex;
+
+    // Buffers returned by leases
+    std::vector<std::unique_ptr<buffers>> idle;
+
+    size_t max_idle;
+    size_t max_capacity;
+}; // !class buffer_pool
+
+#endif // BUFFER_POOL_H
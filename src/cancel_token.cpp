@@ -0,0 +1,140 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "cancel_token.h"
+
+// Hooks are called outside of lock
+#include <vector>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// cancel_token::hook Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+cancel_token::hook::hook(cancel_token *token, hook_func f):
+    token(token),
+    id(0)
+{
+    if (token) id = token->add_hook(std::move(f));
+} // !cancel_token::hook::hook(...)
+
+//
+cancel_token::hook::~hook()
+{
+    if (token) token->remove_hook(id);
+} // !cancel_token::hook::~hook()
+
+// !cancel_token::hook Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// cancel_token Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+cancel_token::cancel_token():
+    cancelled(false),
+    next_id(1),
+    hooks_running(false),
+    parent_hook(0)
+{
+} // !cancel_token::cancel_token()
+
+//
+cancel_token::~cancel_token()
+{
+    if (timer)
+    {
+        boost::system::error_code ec;
+        timer->cancel(ec);
+    }
+    if (parent) parent->remove_hook(parent_hook);
+} // !cancel_token::~cancel_token()
+
+// Make token, which is cancelled with this one
+cancel_token::ptoken cancel_token::make_child()
+{
+    ptoken child = std::make_shared<cancel_token>();
+    std::weak_ptr<cancel_token> weak_child(child);
+    child->parent = shared_from_this();
+    child->parent_hook = add_hook([weak_child]()
+    {
+        if (ptoken child = weak_child.lock()) child->cancel();
+    });
+    return child;
+} // !cancel_token::ptoken cancel_token::make_child()
+
+// Cancel token after duration, even if nobody asks for
+void cancel_token::set_deadline(boost::asio::io_service &io_service,
+                                std::chrono::steady_clock::duration duration)
+{
+    timer = std::make_shared<boost::asio::steady_timer>(io_service, duration);
+    std::weak_ptr<cancel_token> weak_this(shared_from_this());
+    timer->async_wait([weak_this](const boost::system::error_code &ec)
+    {
+        if (ec) return;
+        if (ptoken token = weak_this.lock()) token->cancel();
+    });
+} // !void cancel_token::set_deadline(...)
+
+// Cancel and call all hooks
+void cancel_token::cancel()
+{
+    std::vector<hook_func> to_call;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cancelled) return;
+        cancelled = true;
+        for (auto &i : hooks) to_call.emplace_back(std::move(i.second));
+        hooks.clear();
+        hooks_thread = std::this_thread::get_id();
+        hooks_running = true;
+    }
+
+    // Hook can destroy child token, which removes its hook from here
+    for (auto &i : to_call) i();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    hooks_running = false;
+    hooks_done.notify_all();
+} // !void cancel_token::cancel()
+
+// !cancel_token Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// cancel_token Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Add hook, return its id or 0 if it is already called
+size_t cancel_token::add_hook(hook_func f)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!cancelled)
+        {
+            hooks.emplace(next_id, std::move(f));
+            return next_id++;
+        }
+    }
+    f();
+    return 0;
+} // !size_t cancel_token::add_hook(...)
+
+// Remove hook, or wait if it is running
+void cancel_token::remove_hook(size_t id)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (hooks.erase(id)) return;
+    // Hook may use object of caller, so wait for it
+    while (hooks_running && hooks_thread != std::this_thread::get_id())
+    {
+        hooks_done.wait(lock);
+    }
+} // !void cancel_token::remove_hook(...)
+
+// !cancel_token Private functions
+///////////////////////////////////////////////////////////////////////////////
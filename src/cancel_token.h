@@ -0,0 +1,115 @@
+#ifndef CANCEL_TOKEN_H
+#define CANCEL_TOKEN_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Token is checked by worker threads and cancelled by GUI thread
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+// Hooks called on cancel
+#include <functional>
+#include <map>
+#include <memory>
+// Thrown from check()
+#include <stdexcept>
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Deadline timer
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#endif // Q_MOC_RUN
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Thrown by cancel_token::check() if task is cancelled or too late
+class task_cancelled : public std::runtime_error
+{
+public:
+    task_cancelled(): std::runtime_error("Task cancelled") {}
+}; // !class task_cancelled
+
+// Cooperative cancellation of task
+// Task checks token in its loops, and blocking operations
+// (like socket read) register hook, which interrupts them on cancel.
+class cancel_token : public std::enable_shared_from_this<cancel_token>
+{
+public:
+    typedef std::shared_ptr<cancel_token> ptoken;
+    typedef std::function<void ()> hook_func;
+
+    // Hook is registered while this object lives
+    // Destructor waits if hook is running on other thread
+    class hook
+    {
+    public:
+        // Token may be nullptr - nothing to do then
+        hook(cancel_token *token, hook_func f);
+        ~hook();
+    private:
+        hook(const hook &);
+        hook &operator=(const hook &);
+    private:
+        cancel_token *token;
+        size_t id;
+    }; // !class hook
+
+public:
+    cancel_token();
+
+    ~cancel_token();
+
+    // Make token, which is cancelled with this one
+    ptoken make_child();
+
+    // Cancel token after duration, even if nobody asks for
+    void set_deadline(boost::asio::io_service &io_service,
+                      std::chrono::steady_clock::duration duration);
+
+    // Cancel and call all hooks
+    void cancel();
+
+    bool is_cancelled() const { return cancelled; }
+
+    // Throw task_cancelled if cancelled
+    void check() const
+    {
+        if (cancelled) throw task_cancelled();
+    }
+
+private:
+    // Add hook, return its id or 0 if it is already called
+    size_t add_hook(hook_func f);
+
+    // Remove hook, or wait if it is running
+    void remove_hook(size_t id);
+
+private:
+    std::atomic<bool> cancelled;
+
+    std::mutex mutex;
+    std::condition_variable hooks_done;
+
+    // Id - hook
+    std::map<size_t, hook_func> hooks;
+    size_t next_id;
+
+    // Thread calling hooks now, if any
+    std::thread::id hooks_thread;
+    bool hooks_running;
+
+    // Parent token and id of hook in it
+    ptoken parent;
+    size_t parent_hook;
+
+    // Cancels token after deadline
+    std::shared_ptr<boost::asio::steady_timer> timer;
+}; // !class cancel_token
+
+#endif // CANCEL_TOKEN_H
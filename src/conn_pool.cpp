@@ -0,0 +1,385 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "conn_pool.h"
+
+// Read reply in http_request(...)
+#include "http_reply.h"
+// Endpoints of hosts
+#include "dns_cache.h"
+// Interrupt request on cancel
+#include "cancel_token.h"
+
+// Find Accept-Encoding in request
+#include <boost/algorithm/string.hpp>
+#include <array>
+#include <algorithm>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Accept-Encoding of request
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Encodings that http_reply decodes
+    const std::string accept_encoding("Accept-Encoding: gzip, deflate");
+
+    // Request, header and line end after request line, and the rest
+    typedef std::array<boost::asio::const_buffer, 4> request_buffers;
+
+    // Request with Accept-Encoding after request line without copy of it,
+    // if request has no Accept-Encoding of its own
+    request_buffers with_encoding(const std::string &request)
+    {
+        request_buffers buffers;
+        buffers[3] = boost::asio::buffer(request);
+
+        // Templates may have "\n" or "\r\n" line ends
+        const size_t line_end = request.find('\n');
+        if (line_end == request.npos) return buffers;
+        size_t head_end = std::min(request.find("\n\n"),
+                                   request.find("\n\r\n"));
+        if (head_end == request.npos) head_end = request.size();
+        const boost::iterator_range<std::string::const_iterator> head(
+                    request.begin(), request.begin()+head_end);
+        if (boost::ifind_first(head, "accept-encoding:")) return buffers;
+
+        const bool crlf = line_end && request[line_end-1] == '\r';
+        buffers[0] = boost::asio::buffer(request.data(), line_end+1);
+        buffers[1] = boost::asio::buffer(accept_encoding);
+        buffers[2] = boost::asio::buffer(crlf ? "\r\n" : "\n", crlf ? 2 : 1);
+        buffers[3] = boost::asio::buffer(request.data()+line_end+1,
+                                         request.size()-line_end-1);
+        return buffers;
+    }
+} // !namespace
+
+// !Accept-Encoding of request
+///////////////////////////////////////////////////////////////////////////////
+
+
+// conn_pool::lease Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+conn_pool::lease::lease(lease &&ref):
+    pool(ref.pool),
+    key(std::move(ref.key)),
+    sock(std::move(ref.sock)),
+    reused(ref.reused)
+{
+    ref.pool = nullptr;
+} // !conn_pool::lease::lease(...)
+
+//
+conn_pool::lease &conn_pool::lease::operator=(lease &&ref)
+{
+    if (this != &ref)
+    {
+        // Close own connection first
+        if (pool) pool->drop(key);
+        pool = ref.pool;
+        key = std::move(ref.key);
+        sock = std::move(ref.sock);
+        reused = ref.reused;
+        ref.pool = nullptr;
+    }
+    return *this;
+} // !conn_pool::lease &conn_pool::lease::operator=(...)
+
+//
+conn_pool::lease::~lease()
+{
+    if (pool) pool->drop(key);
+} // !conn_pool::lease::~lease()
+
+// Return connection back to pool for the next request
+void conn_pool::lease::release()
+{
+    if (!pool) return;
+    pool->put(key, std::move(sock));
+    pool = nullptr;
+} // !void conn_pool::lease::release()
+
+// !conn_pool::lease Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// conn_pool::lease Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+conn_pool::lease::lease(conn_pool *pool, const std::string &key,
+                        psocket sock, bool reused):
+    pool(pool),
+    key(key),
+    sock(std::move(sock)),
+    reused(reused)
+{
+} // !conn_pool::lease::lease(...)
+
+// !conn_pool::lease Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// conn_pool Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+conn_pool::conn_pool(boost::asio::io_service &io_service, dns_cache &dns):
+    io_service(io_service),
+    dns(dns),
+    max_conn(4),
+    idle_timeout(60)
+{
+} // !conn_pool::conn_pool(...)
+
+//
+conn_pool::~conn_pool()
+{
+    clear();
+} // !conn_pool::~conn_pool()
+
+// Max connections to one host and time to keep idle connection
+void conn_pool::set_limits(size_t max_conn, std::chrono::seconds idle_timeout)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->max_conn = max_conn ? max_conn : 1;
+    this->idle_timeout = idle_timeout;
+    freed.notify_all();
+} // !void conn_pool::set_limits(...)
+
+// Get idle connection to host or connect new one
+conn_pool::lease conn_pool::get(const std::string &host,
+                                const std::string &port,
+                                request_timing *timing)
+{
+    const std::string key = host + ':' + port;
+
+    // Check idle connections, until alive one is found
+    for (psocket sock; (sock = reserve(key, true)); )
+    {
+        if (!is_stale(*sock)) return lease(this, key, std::move(sock), true);
+        drop(key);
+    }
+
+    // No idle connections, place is reserved - connect new one
+    try
+    {
+        return lease(this, key, connect(host, port, timing), false);
+    }
+    catch (...)
+    {
+        drop(key);
+        throw;
+    }
+} // !conn_pool::lease conn_pool::get(...)
+
+// Connect new one, even if there are idle connections
+conn_pool::lease conn_pool::get_new(const std::string &host,
+                                    const std::string &port,
+                                    request_timing *timing)
+{
+    const std::string key = host + ':' + port;
+    reserve(key, false);
+    try
+    {
+        return lease(this, key, connect(host, port, timing), false);
+    }
+    catch (...)
+    {
+        drop(key);
+        throw;
+    }
+} // !conn_pool::lease conn_pool::get_new(...)
+
+// Open up to num connections to host in advance
+void conn_pool::warm(const std::string &host, const std::string &port,
+                     size_t num)
+{
+    const std::string key = host + ':' + port;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        host_conns &conns = hosts[key];
+        evict(conns);
+        size_t has = conns.idle.size() + conns.busy;
+        if (num > max_conn) num = max_conn;
+        num = has < num ? num - has : 0;
+    }
+    for (; num; --num) get_new(host, port).release();
+} // !void conn_pool::warm(...)
+
+// Close all idle connections
+void conn_pool::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &i : hosts) i.second.idle.clear();
+} // !void conn_pool::clear()
+
+// !conn_pool Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// conn_pool Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Take place for connection to host, wait if there is no place
+// return idle connection if any
+conn_pool::psocket conn_pool::reserve(const std::string &key, bool want_idle)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    host_conns &conns = hosts[key];
+    for (;;)
+    {
+        evict(conns);
+        if (want_idle && conns.idle.size())
+        {
+            // The most recent one is the most likely alive
+            psocket sock = std::move(conns.idle.back().first);
+            conns.idle.pop_back();
+            ++conns.busy;
+            return sock;
+        }
+        if (conns.busy + conns.idle.size() < max_conn)
+        {
+            ++conns.busy;
+            return psocket();
+        }
+        // Make place for the new one
+        if (conns.idle.size())
+        {
+            conns.idle.pop_front();
+            continue;
+        }
+        freed.wait(lock);
+    }
+} // !conn_pool::psocket conn_pool::reserve(...)
+
+// Connect new socket to host
+conn_pool::psocket conn_pool::connect(const std::string &host,
+                                      const std::string &port,
+                                      request_timing *timing)
+{
+    typedef request_timing::clock clock;
+    const clock::time_point start = clock::now();
+
+    psocket sock(new socket_type(io_service));
+    const dns_cache::endpoints eps = dns.resolve(host, port);
+    const clock::time_point resolved = clock::now();
+    boost::asio::connect(*sock, eps.begin(), eps.end());
+    sock->set_option(boost::asio::ip::tcp::no_delay(true));
+
+    if (timing)
+    {
+        timing->dns += resolved - start;
+        timing->connect += clock::now() - resolved;
+    }
+    return sock;
+} // !conn_pool::psocket conn_pool::connect(...)
+
+// Return connection from lease
+void conn_pool::put(const std::string &key, psocket sock)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    host_conns &conns = hosts[key];
+    --conns.busy;
+    conns.idle.emplace_back(std::move(sock), clock::now());
+    freed.notify_one();
+} // !void conn_pool::put(...)
+
+// Free place of closed connection
+void conn_pool::drop(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    --hosts[key].busy;
+    freed.notify_one();
+} // !void conn_pool::drop(...)
+
+// Close connections idle for too long, must be locked
+void conn_pool::evict(host_conns &conns)
+{
+    const clock::time_point old = clock::now() - idle_timeout;
+    while (conns.idle.size() && conns.idle.front().second < old)
+    {
+        conns.idle.pop_front();
+    }
+} // !void conn_pool::evict(...)
+
+// Server closed idle connection or sent something unexpected
+bool conn_pool::is_stale(socket_type &sock)
+{
+    boost::system::error_code ec;
+    char c;
+    // Peek without waiting: would_block means connection is alive and silent
+    sock.non_blocking(true, ec);
+    if (ec) return true;
+    sock.receive(boost::asio::buffer(&c, 1),
+                 boost::asio::socket_base::message_peek, ec);
+    bool stale = ec != boost::asio::error::would_block;
+    sock.non_blocking(false, ec);
+    return stale || ec;
+} // !bool conn_pool::is_stale(...)
+
+// !conn_pool Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Send request with pooled connection and read one reply
+void http_request(conn_pool &pool,
+                  const std::string &host, const std::string &port,
+                  const std::string &request, http_reply &reply,
+                  cancel_token *token, request_timing *timing)
+{
+    // Site's pages are text, so they are asked compressed
+    const request_buffers buffers = with_encoding(request);
+
+    // Write request and read reply, which can be interrupted by token
+    auto send = [&](conn_pool::lease &conn)
+    {
+        cancel_token::hook hook(token, [&conn]()
+        {
+            // Blocking read returns at once
+            boost::system::error_code ec;
+            conn.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_both,
+                                   ec);
+        });
+        boost::asio::write(conn.socket(), buffers);
+        read_http_reply(conn.socket(), reply, token, timing);
+    };
+
+    if (token) token->check();
+    conn_pool::lease conn = pool.get(host, port, timing);
+    try
+    {
+        send(conn);
+    }
+    catch (std::runtime_error &)
+    {
+        // Broken socket is expected after cancel
+        if (token) token->check();
+
+        // Server may close keep-alive connection at any moment
+        // and this isn't an error, if nothing was received yet
+        if (!conn.is_reused() || reply.head().size() || reply.status())
+            throw;
+
+        // Free place of the dead one and connect again
+        conn = conn_pool::lease();
+        conn = pool.get_new(host, port, timing);
+        reply.reset();
+        try
+        {
+            send(conn);
+        }
+        catch (std::runtime_error &)
+        {
+            if (token) token->check();
+            throw;
+        }
+    }
+
+    if (reply.keep_alive()) conn.release();
+} // !void http_request(...)
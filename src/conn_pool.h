@@ -0,0 +1,166 @@
+#ifndef CONN_POOL_H
+#define CONN_POOL_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Connections are shared between worker threads
+#include <mutex>
+#include <condition_variable>
+// Idle time of connection
+#include <chrono>
+// Connections of every host
+#include <map>
+#include <list>
+#include <memory>
+#include <string>
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Network:
+#include <boost/asio.hpp>
+
+#endif // Q_MOC_RUN
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+class http_reply;
+class dns_cache;
+class cancel_token;
+struct request_timing;
+
+// !Forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+// Keep-alive connections to every host
+// Connection is borrowed for one request and then returned,
+// so the next request doesn't need TCP handshake
+class conn_pool
+{
+public:
+    typedef boost::asio::ip::tcp::socket socket_type;
+    typedef std::unique_ptr<socket_type> psocket;
+    typedef std::chrono::steady_clock clock;
+
+    // Borrowed connection
+    // It is closed on destruction, unless release() was called
+    class lease
+    {
+    public:
+        lease(): pool(nullptr), reused(false) {}
+        lease(lease &&ref);
+        lease &operator=(lease &&ref);
+        ~lease();
+
+        socket_type &socket() { return *sock; }
+
+        // Connection was used before, so it could be closed by server
+        bool is_reused() const { return reused; }
+
+        // Return connection back to pool for the next request
+        void release();
+
+    private:
+        friend class conn_pool;
+        lease(conn_pool *pool, const std::string &key,
+              psocket sock, bool reused);
+        lease(const lease &);
+        lease &operator=(const lease &);
+
+    private:
+        conn_pool *pool;
+        std::string key;
+        psocket sock;
+        bool reused;
+    }; // !class lease
+
+public:
+    conn_pool(boost::asio::io_service &io_service, dns_cache &dns);
+
+    ~conn_pool();
+
+    // Max connections to one host and time to keep idle connection
+    void set_limits(size_t max_conn, std::chrono::seconds idle_timeout);
+
+    // Get idle connection to host or connect new one
+    // Wait if all max_conn connections are busy
+    // Time of lookup and connect is added to timing, if any
+    lease get(const std::string &host, const std::string &port,
+              request_timing *timing = nullptr);
+
+    // Connect new one, even if there are idle connections
+    lease get_new(const std::string &host, const std::string &port,
+                  request_timing *timing = nullptr);
+
+    // Open up to num connections to host in advance
+    void warm(const std::string &host, const std::string &port, size_t num);
+
+    // Close all idle connections
+    void clear();
+
+private:
+    // Connections to one host
+    struct host_conns
+    {
+        host_conns(): busy(0) {}
+        // Idle connections and time when they became idle
+        std::list<std::pair<psocket, clock::time_point>> idle;
+        // Borrowed connections
+        size_t busy;
+    };
+
+private:
+    // Take place for connection to host, wait if there is no place
+    // return idle connection if any
+    psocket reserve(const std::string &key, bool want_idle);
+
+    // Connect new socket to host
+    psocket connect(const std::string &host, const std::string &port,
+                    request_timing *timing);
+
+    // Return connection from lease
+    void put(const std::string &key, psocket sock);
+
+    // Free place of closed connection
+    void drop(const std::string &key);
+
+    // Close connections idle for too long, must be locked
+    void evict(host_conns &conns);
+
+    // Server closed idle connection or sent something unexpected
+    static bool is_stale(socket_type &sock);
+
+private:
+    boost::asio::io_service &io_service;
+
+    // Endpoints of hosts
+    dns_cache &dns;
+
+    std::mutex mutex;
+    std::condition_variable freed;
+
+    // host:port - connections
+    std::map<std::string, host_conns> hosts;
+
+    size_t max_conn;
+    std::chrono::seconds idle_timeout;
+}; // !class conn_pool
+
+// Send request with pooled connection and read one reply
+// Accept-Encoding: gzip, deflate is added, if request has no Accept-Encoding
+// If reused connection is already closed by server - reconnect and resend
+// Cancel of token interrupts blocking read and throws task_cancelled
+// Time of request phases is added to timing, if any
+void http_request(conn_pool &pool,
+                  const std::string &host, const std::string &port,
+                  const std::string &request, http_reply &reply,
+                  cancel_token *token = nullptr,
+                  request_timing *timing = nullptr);
+
+#endif // CONN_POOL_H
@@ -0,0 +1,385 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "crawl_state.h"
+
+// remove, rename
+#include <cstdio>
+#include <algorithm>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Record fields in file
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Record bigger than this is garbage
+    const std::uint32_t max_record = 16 << 20;
+
+    // Record: kind, size of payload, payload
+    const size_t header_size = 4+4;
+
+    template <class T>
+    void put_field(std::string &out, T value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void put_string(std::string &out, const std::string &value)
+    {
+        put_field(out, static_cast<std::uint32_t>(value.size()));
+        out += value;
+    }
+
+    // Reads fields of payload, ok is false if payload is too short
+    struct reader
+    {
+        reader(const std::string &data): data(data), pos(0), ok(true) {}
+
+        template <class T>
+        T field()
+        {
+            T value = T();
+            if (pos + sizeof(value) > data.size())
+            {
+                ok = false;
+                return value;
+            }
+            std::copy(data.data()+pos, data.data()+pos+sizeof(value),
+                      reinterpret_cast<char*>(&value));
+            pos += sizeof(value);
+            return value;
+        }
+
+        std::string string()
+        {
+            const std::uint32_t size = field<std::uint32_t>();
+            if (!ok || pos + size > data.size())
+            {
+                ok = false;
+                return std::string();
+            }
+            pos += size;
+            return data.substr(pos-size, size);
+        }
+
+        const std::string &data;
+        size_t pos;
+        bool ok;
+    };
+
+    template <class T>
+    bool read_field(std::istream &in, T &value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value),
+                                         sizeof(value)));
+    }
+} // !namespace
+
+// !Record fields in file
+///////////////////////////////////////////////////////////////////////////////
+
+
+// crawl_state Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+crawl_state::crawl_state():
+    run_start(0),
+    last_page(0),
+    run_finished(true),
+    records(0),
+    file_size(0)
+{
+} // !crawl_state::crawl_state()
+
+// Open file, or create it, and read its records
+void crawl_state::open(const std::string &filename)
+{
+    close();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    this->filename = filename;
+
+    const auto mode = std::ios::in | std::ios::out | std::ios::binary;
+    file.open(filename, mode);
+    if (!file.is_open())
+    {
+        std::ofstream(filename, std::ios::binary);
+        file.open(filename, mode);
+        if (!file.is_open()) return;
+    }
+
+    // Torn record at the end, after crash, or many old records
+    if (!load() || records > 2*(pages.size()+1)) compact();
+} // !void crawl_state::open(...)
+
+// Close file and forget everything
+void crawl_state::close()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) file.close();
+    file.clear();
+    pages.clear();
+    run_start = 0;
+    last_page = 0;
+    run_finished = true;
+    records = 0;
+    file_size = 0;
+} // !void crawl_state::close()
+
+// Start search from the first page and return start of its run
+std::time_t crawl_state::begin_run(std::time_t resume_ttl)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::time_t now = std::time(nullptr);
+    if (!run_finished && now - run_start < resume_ttl) return run_start;
+
+    run_start = now;
+    last_page = 0;
+    run_finished = false;
+    append(rec_run, run_record());
+    return run_start;
+} // !std::time_t crawl_state::begin_run(...)
+
+// Search found all it needed
+void crawl_state::end_run()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    run_finished = true;
+    append(rec_run, run_record());
+} // !void crawl_state::end_run()
+
+// Last received state of page, if any
+bool crawl_state::get(size_t page_num, page &out_page)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pages.find(page_num);
+    if (it == pages.end()) return false;
+    out_page = it->second;
+    return true;
+} // !bool crawl_state::get(...)
+
+// Page is received, save it as checkpoint
+void crawl_state::put(size_t page_num, const page &new_page)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pages[page_num] = new_page;
+    last_page = std::max(last_page, page_num);
+    append(rec_page, page_record(page_num, new_page));
+} // !void crawl_state::put(...)
+
+// Server replied "Not Modified" or body has the same hash
+void crawl_state::touch(size_t page_num)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pages.find(page_num);
+    if (it == pages.end()) return;
+    it->second.fetched = std::time(nullptr);
+    last_page = std::max(last_page, page_num);
+    append(rec_touch, touch_record(page_num, it->second.fetched));
+} // !void crawl_state::touch(...)
+
+// Hash of body for put(), FNV-1a, fed piece by piece
+std::uint64_t crawl_state::hash_body(const char *data, size_t size,
+                                     std::uint64_t hash)
+{
+    for (const char *end = data+size; data != end; ++data)
+    {
+        hash ^= static_cast<unsigned char>(*data);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+} // !std::uint64_t crawl_state::hash_body(...)
+
+// !crawl_state Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// crawl_state Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Read records from file, return false if the last one is torn
+bool crawl_state::load()
+{
+    pages.clear();
+    records = 0;
+
+    file.clear();
+    file.seekg(0, std::ios::end);
+    const std::uint64_t end = static_cast<std::uint64_t>(file.tellg());
+    file.seekg(0);
+
+    std::uint64_t offset = 0;
+    std::uint32_t kind;
+    std::uint32_t size;
+    std::string payload;
+    while (read_field(file, kind) && read_field(file, size))
+    {
+        if (size > max_record || offset + header_size + size > end) break;
+        payload.resize(size);
+        if (size && !file.read(&payload[0], size)) break;
+
+        reader in(payload);
+        if (kind == rec_page)
+        {
+            const size_t page_num =
+                    static_cast<size_t>(in.field<std::uint64_t>());
+            page p;
+            p.fetched = static_cast<std::time_t>(in.field<std::int64_t>());
+            p.hash = in.field<std::uint64_t>();
+            p.etag = in.string();
+            p.last_modified = in.string();
+            std::uint32_t count = in.field<std::uint32_t>();
+            for (; in.ok && count; --count)
+            {
+                book b;
+                b.id = in.field<std::uint64_t>();
+                b.title = in.string();
+                p.books.push_back(std::move(b));
+            }
+            if (!in.ok) break;
+            pages[page_num] = std::move(p);
+        }
+        else if (kind == rec_touch)
+        {
+            const size_t page_num =
+                    static_cast<size_t>(in.field<std::uint64_t>());
+            const std::time_t fetched =
+                    static_cast<std::time_t>(in.field<std::int64_t>());
+            if (!in.ok) break;
+            auto it = pages.find(page_num);
+            if (it != pages.end()) it->second.fetched = fetched;
+        }
+        else if (kind == rec_run)
+        {
+            run_start = static_cast<std::time_t>(in.field<std::int64_t>());
+            last_page = static_cast<size_t>(in.field<std::uint64_t>());
+            run_finished = in.field<std::uint8_t>() != 0;
+            if (!in.ok) break;
+        }
+        else break;
+
+        ++records;
+        offset += header_size + size;
+    }
+    file.clear();
+
+    // Pages received by unfinished run after its last record
+    if (!run_finished)
+    {
+        for (auto &i : pages)
+        {
+            if (i.second.fetched > run_start)
+                last_page = std::max(last_page, i.first);
+        }
+    }
+
+    // Next record is written over torn one
+    file_size = offset;
+    return offset == end;
+} // !bool crawl_state::load()
+
+// Rewrite file with the last state of every page
+void crawl_state::compact()
+{
+    // Write kept records to temporary file
+    const std::string tmp_filename = filename + ".tmp";
+    {
+        std::ofstream tmp(tmp_filename, std::ios::binary | std::ios::trunc);
+        if (!tmp.is_open()) return;
+
+        std::string record;
+        auto write = [&](record_kind kind, const std::string &payload)
+        {
+            record.clear();
+            put_field(record, static_cast<std::uint32_t>(kind));
+            put_field(record, static_cast<std::uint32_t>(payload.size()));
+            record += payload;
+            tmp.write(record.data(), record.size());
+        };
+        for (auto &i : pages) write(rec_page, page_record(i.first, i.second));
+        write(rec_run, run_record());
+
+        tmp.flush();
+        if (!tmp) return;
+    }
+
+    // and replace old file with it
+    file.close();
+    file.clear();
+    std::remove(filename.c_str());
+    std::rename(tmp_filename.c_str(), filename.c_str());
+    file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+    if (file.is_open()) load();
+    else pages.clear();
+} // !void crawl_state::compact()
+
+// Write record at the end of file
+void crawl_state::append(record_kind kind, const std::string &payload)
+{
+    if (!file.is_open()) return;
+
+    std::string record;
+    put_field(record, static_cast<std::uint32_t>(kind));
+    put_field(record, static_cast<std::uint32_t>(payload.size()));
+    record += payload;
+
+    file.clear();
+    file.seekp(file_size);
+    file.write(record.data(), record.size());
+    file.flush();
+    if (!file)
+    {
+        // Part of record may be written, it is dropped by next load()
+        file.clear();
+        return;
+    }
+
+    ++records;
+    file_size += record.size();
+} // !void crawl_state::append(...)
+
+// Payload of page record
+std::string crawl_state::page_record(size_t page_num, const page &p) const
+{
+    std::string out;
+    put_field(out, static_cast<std::uint64_t>(page_num));
+    put_field(out, static_cast<std::int64_t>(p.fetched));
+    put_field(out, p.hash);
+    put_string(out, p.etag);
+    put_string(out, p.last_modified);
+    put_field(out, static_cast<std::uint32_t>(p.books.size()));
+    for (const book &b : p.books)
+    {
+        put_field(out, static_cast<std::uint64_t>(b.id));
+        put_string(out, b.title);
+    }
+    return out;
+} // !std::string crawl_state::page_record(...) const
+
+// Payload of touch record
+std::string crawl_state::touch_record(size_t page_num,
+                                      std::time_t fetched) const
+{
+    std::string out;
+    put_field(out, static_cast<std::uint64_t>(page_num));
+    put_field(out, static_cast<std::int64_t>(fetched));
+    return out;
+} // !std::string crawl_state::touch_record(...) const
+
+// Payload of run record
+std::string crawl_state::run_record() const
+{
+    std::string out;
+    put_field(out, static_cast<std::int64_t>(run_start));
+    put_field(out, static_cast<std::uint64_t>(last_page));
+    put_field(out, static_cast<std::uint8_t>(run_finished));
+    return out;
+} // !std::string crawl_state::run_record() const
+
+// !crawl_state Private functions
+///////////////////////////////////////////////////////////////////////////////
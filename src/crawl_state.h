@@ -0,0 +1,134 @@
+#ifndef CRAWL_STATE_H
+#define CRAWL_STATE_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// State is shared between search task and page tasks
+#include <mutex>
+// State file
+#include <fstream>
+// Page number - its state
+#include <map>
+#include <vector>
+#include <string>
+// Fixed size fields in file
+#include <cstdint>
+// Time of page and run
+#include <ctime>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// What the last searches found on listing pages, by page number
+// Every page keeps validators from server (ETag, Last-Modified),
+// hash of its body and all books on it, excluded or not, so unchanged page
+// isn't downloaded and parsed again.
+// Run is one search from the first page. Pages are checkpointed as they
+// are received, so search after crash or cancel resumes the unfinished run.
+// File is append-only: the last record of page is valid.
+class crawl_state
+{
+public:
+    // Book found on page
+    struct book
+    {
+        unsigned long long id;
+        std::string title;
+    };
+
+    // Page as it was received last time
+    struct page
+    {
+        page(): fetched(0), hash(0) {}
+
+        // When page was received or validated by server
+        std::time_t fetched;
+        // Hash of body, see hash_body()
+        std::uint64_t hash;
+        // Validators for conditional GET, empty if server sent none
+        std::string etag;
+        std::string last_modified;
+        // All books of page in listing order
+        std::vector<book> books;
+    };
+
+public:
+    crawl_state();
+
+    // Open file, or create it, and read its records
+    void open(const std::string &filename);
+
+    // Close file and forget everything
+    void close();
+
+    // Start search from the first page and return start of its run
+    // Unfinished run, started less than resume_ttl seconds ago, goes on
+    // and its pages are used without requests.
+    // Pages of run are fetched later than returned time, so page of
+    // finished run isn't taken for page of new one in the same second.
+    std::time_t begin_run(std::time_t resume_ttl);
+
+    // Search found all it needed
+    void end_run();
+
+    // Last received state of page, if any
+    bool get(size_t page_num, page &out_page);
+
+    // Page is received, save it as checkpoint
+    void put(size_t page_num, const page &new_page);
+
+    // Server replied "Not Modified" or body has the same hash
+    void touch(size_t page_num);
+
+    // Hash of body for put(), FNV-1a, fed piece by piece
+    static std::uint64_t hash_body(const char *data, size_t size,
+                                   std::uint64_t hash = hash_seed);
+
+    static const std::uint64_t hash_seed = 14695981039346656037ULL;
+
+private:
+    // Kind of record in file
+    enum record_kind
+    {
+        rec_page = 1,   // Whole page
+        rec_touch = 2,  // Page's new fetched time
+        rec_run = 3     // Run's start and end
+    };
+
+private:
+    // Read records from file, return false if the last one is torn
+    bool load();
+
+    // Rewrite file with the last state of every page
+    void compact();
+
+    // Write record at the end of file
+    void append(record_kind kind, const std::string &payload);
+
+    // Payloads of records
+    std::string page_record(size_t page_num, const page &p) const;
+    std::string touch_record(size_t page_num, std::time_t fetched) const;
+    std::string run_record() const;
+
+private:
+    std::mutex mutex;
+
+    std::string filename;
+    std::fstream file;
+
+    // Page number - the last state of it
+    std::map<size_t, page> pages;
+
+    // The last run
+    std::time_t run_start;
+    size_t last_page;
+    bool run_finished;
+
+    // Records read and written, compacted when much bigger than pages
+    size_t records;
+    // Position after the last record
+    std::uint64_t file_size;
+}; // !class crawl_state
+
+#endif // CRAWL_STATE_H
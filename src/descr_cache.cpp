@@ -0,0 +1,251 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "descr_cache.h"
+
+// Newest records first while compacting
+#include <vector>
+#include <algorithm>
+// remove, rename
+#include <cstdio>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Record header in file
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Record bigger than this is garbage
+    const std::uint32_t max_record = 1 << 20;
+
+    template <class T>
+    void write_field(std::ostream &out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <class T>
+    bool read_field(std::istream &in, T &value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value),
+                                         sizeof(value)));
+    }
+} // !namespace
+
+// !Record header in file
+///////////////////////////////////////////////////////////////////////////////
+
+
+// descr_cache Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+descr_cache::descr_cache():
+    file_size(0),
+    ttl(0),
+    max_size(0)
+{
+} // !descr_cache::descr_cache()
+
+// Open file, or create it, and index its records
+// Records older than ttl are stale, file is kept under max_size bytes
+void descr_cache::open(const std::string &filename, std::time_t ttl,
+                       size_t max_size)
+{
+    close();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    this->filename = filename;
+    this->ttl = ttl;
+    this->max_size = max_size;
+    // Cache is off
+    if (!max_size) return;
+
+    const auto mode = std::ios::in | std::ios::out | std::ios::binary;
+    file.open(filename, mode);
+    if (!file.is_open())
+    {
+        std::ofstream(filename, std::ios::binary);
+        file.open(filename, mode);
+        if (!file.is_open()) return;
+    }
+
+    // Torn record at the end, after crash, or too big file
+    if (!load() || file_size > max_size) compact();
+} // !void descr_cache::open(...)
+
+// Close file and forget everything
+void descr_cache::close()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) file.close();
+    file.clear();
+    entries.clear();
+    file_size = 0;
+} // !void descr_cache::close()
+
+// Description of book, if any
+// stale is true if it should be refreshed
+bool descr_cache::get(unsigned long long id, std::string &out_descr,
+                      bool &stale)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(id);
+    if (it == entries.end()) return false;
+
+    out_descr = read(it->second);
+    if (out_descr.size() != it->second.size)
+    {
+        // File is broken here, so forget record
+        entries.erase(it);
+        return false;
+    }
+    stale = std::time(nullptr) - it->second.time > ttl;
+    return true;
+} // !bool descr_cache::get(...)
+
+// Add or replace description of book
+void descr_cache::put(unsigned long long id, const std::string &descr)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file.is_open() || descr.size() > max_record) return;
+
+    header head;
+    head.id = id;
+    head.time = std::time(nullptr);
+    head.size = static_cast<std::uint32_t>(descr.size());
+    append(head, descr.data());
+
+    if (file_size > max_size) compact();
+} // !void descr_cache::put(...)
+
+// !descr_cache Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// descr_cache Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Read records from file, return false if the last one is torn
+bool descr_cache::load()
+{
+    entries.clear();
+
+    file.clear();
+    file.seekg(0, std::ios::end);
+    const std::uint64_t end = static_cast<std::uint64_t>(file.tellg());
+    file.seekg(0);
+
+    std::uint64_t offset = 0;
+    header head;
+    while (read_field(file, head.id) &&
+           read_field(file, head.time) &&
+           read_field(file, head.size))
+    {
+        if (head.size > max_record ||
+            offset + header_size + head.size > end) break;
+
+        // The last record of id replaces previous ones
+        entry &ent = entries[head.id];
+        ent.offset = offset;
+        ent.size = head.size;
+        ent.time = static_cast<std::time_t>(head.time);
+
+        offset += header_size + head.size;
+        file.seekg(offset);
+    }
+    file.clear();
+
+    // Next record is written over torn one
+    file_size = offset;
+    return offset == end;
+} // !bool descr_cache::load()
+
+// Rewrite file with the newest records, which take up to max_size/2
+void descr_cache::compact()
+{
+    typedef std::pair<unsigned long long, entry> record;
+    std::vector<record> records(entries.begin(), entries.end());
+    std::sort(records.begin(), records.end(),
+              [](const record &a, const record &b)
+    {
+        return a.second.time > b.second.time;
+    });
+
+    // Write kept records to temporary file
+    const std::string tmp_filename = filename + ".tmp";
+    {
+        std::ofstream tmp(tmp_filename, std::ios::binary | std::ios::trunc);
+        if (!tmp.is_open()) return;
+
+        std::uint64_t size = 0;
+        for (auto &i : records)
+        {
+            size += header_size + i.second.size;
+            if (size > max_size/2) break;
+
+            const std::string descr = read(i.second);
+            if (descr.size() != i.second.size) continue;
+            write_field(tmp, static_cast<std::uint64_t>(i.first));
+            write_field(tmp, static_cast<std::int64_t>(i.second.time));
+            write_field(tmp, i.second.size);
+            tmp.write(descr.data(), descr.size());
+        }
+        tmp.flush();
+        if (!tmp) return;
+    }
+
+    // and replace old file with it
+    file.close();
+    file.clear();
+    std::remove(filename.c_str());
+    std::rename(tmp_filename.c_str(), filename.c_str());
+    file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+    if (file.is_open()) load();
+    else entries.clear();
+} // !void descr_cache::compact()
+
+// Write record at the end of file
+void descr_cache::append(const header &head, const char *data)
+{
+    file.clear();
+    file.seekp(file_size);
+    write_field(file, head.id);
+    write_field(file, head.time);
+    write_field(file, head.size);
+    file.write(data, head.size);
+    file.flush();
+    if (!file)
+    {
+        // Part of record may be written, it is dropped by next load()
+        file.clear();
+        return;
+    }
+
+    entry &ent = entries[head.id];
+    ent.offset = file_size;
+    ent.size = head.size;
+    ent.time = static_cast<std::time_t>(head.time);
+
+    file_size += header_size + head.size;
+} // !void descr_cache::append(...)
+
+// Read description of entry
+std::string descr_cache::read(const entry &ent)
+{
+    std::string descr(ent.size, '\0');
+    file.clear();
+    file.seekg(ent.offset + header_size);
+    if (!file.read(&descr[0], ent.size))
+    {
+        file.clear();
+        return std::string();
+    }
+    return descr;
+} // !std::string descr_cache::read(...)
+
+// !descr_cache Private functions
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,95 @@
+#ifndef DESCR_CACHE_H
+#define DESCR_CACHE_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Cache is shared between worker threads and GUI
+#include <mutex>
+// Segment file
+#include <fstream>
+// Id - position of its description in file
+#include <unordered_map>
+#include <string>
+// Fixed size of record header
+#include <cstdint>
+// Time of record
+#include <ctime>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Book descriptions on disk, keyed by book id
+// File is append-only: every put() adds a record, the last one is valid.
+// Positions of valid records are kept in memory.
+// When file grows over its size limit, it is rewritten with the newest
+// records only. Stale records are still returned, so caller can show them
+// and refresh in background.
+class descr_cache
+{
+public:
+    descr_cache();
+
+    // Open file, or create it, and index its records
+    // Records older than ttl are stale, file is kept under max_size bytes
+    void open(const std::string &filename, std::time_t ttl, size_t max_size);
+
+    // Close file and forget everything
+    void close();
+
+    // Description of book, if any
+    // stale is true if it should be refreshed
+    bool get(unsigned long long id, std::string &out_descr, bool &stale);
+
+    // Add or replace description of book
+    void put(unsigned long long id, const std::string &descr);
+
+private:
+    // Record in file: header and description
+    struct header
+    {
+        std::uint64_t id;
+        std::int64_t time;
+        std::uint32_t size;
+    };
+
+    // Position of record in file
+    struct entry
+    {
+        std::uint64_t offset;
+        std::uint32_t size;
+        std::time_t time;
+    };
+
+    static const size_t header_size = 8+8+4;
+
+private:
+    // Read records from file, return false if the last one is torn
+    bool load();
+
+    // Rewrite file with the newest records, which take up to max_size/2
+    void compact();
+
+    // Write record at the end of file
+    void append(const header &head, const char *data);
+
+    // Read description of entry
+    std::string read(const entry &ent);
+
+private:
+    std::mutex mutex;
+
+    std::string filename;
+    std::fstream file;
+
+    // Id - its last record
+    std::unordered_map<unsigned long long, entry> entries;
+
+    // Position after the last record
+    std::uint64_t file_size;
+
+    std::time_t ttl;
+    size_t max_size;
+}; // !class descr_cache
+
+#endif // DESCR_CACHE_H
@@ -0,0 +1,94 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "descr_parser.h"
+
+// Search for end of description
+#include "scan.h"
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Get book's description from book page
+bool parse_for_descr(boost::string_ref page, tag_index &index,
+                     book_descr &out_descr)
+{
+    static const char similar[] = "data-content=\"Похожие книги\">";
+
+    const char *src_beg = page.data();
+    const char *src_end = src_beg+page.size();
+
+    // All the necessary information is found
+    const char *end_pos = scan::find(src_beg, src_end,
+                                     similar, sizeof(similar)-1);
+    if (end_pos == src_end) return false;
+
+    // Elements of the whole page in one pass
+    index.build(src_beg, src_end);
+
+    // Book name is the last one before similar books
+    size_t name = index.rfind("span", "fn", end_pos-src_beg+1);
+    if (name == tag_index::npos) return false;
+    size_t beg_pos = index[name].open_beg;
+
+    out_descr.name = find_by_tag(index, "span", "fn", beg_pos, 0);
+    out_descr.average = find_by_tag(index, "span", "average", beg_pos, 0);
+    out_descr.votes = find_by_tag(index, "span", "votes", beg_pos, 0);
+    out_descr.summary = find_by_tag(index, "p", "summary", beg_pos, 1);
+    return true;
+} // !bool parse_for_descr(...)
+
+// First element with tag and class after in_beg_pos,
+// with its tags if "with" == true, or empty slice
+boost::string_ref find_by_tag(const tag_index &index,
+                              const char *tag, const char *cls,
+                              size_t &in_beg_pos, bool with)
+{
+    size_t i = index.find(tag, cls, in_beg_pos);
+    if (i == tag_index::npos) return boost::string_ref();
+
+    in_beg_pos = index[i].close_end;
+    // With tag
+    if (with) return boost::string_ref(index.outer_beg(i), index.outer_size(i));
+    // without
+    return boost::string_ref(index.inner_beg(i), index.inner_size(i));
+} // !boost::string_ref find_by_tag(...)
+
+// Write description of book with id as html
+void format_descr(const book_descr &descr, boost::string_ref id,
+                  std::string &out_str)
+{
+    static const char name_beg[] = "<center><h1>";
+    static const char name_end[] = "</h1></center>";
+    static const char average[] = "Оценка: ";
+    static const char votes[] = "Проголосовавших: ";
+    static const char br[] = "<br>";
+    static const char link_beg[] = "<a href=\"http://books.imhonet.ru/element/";
+    static const char link_end[] = "\">Посмотреть книгу на сайте</a>";
+
+    // Literals and slices are counted once, so string grows once
+    const size_t literals = sizeof(name_beg)-1 + sizeof(name_end)-1 +
+                            sizeof(average)-1 + sizeof(votes)-1 +
+                            3*(sizeof(br)-1) +
+                            sizeof(link_beg)-1 + sizeof(link_end)-1;
+    out_str.clear();
+    out_str.reserve(literals + descr.name.size() + descr.average.size() +
+                    descr.votes.size() + descr.summary.size() + id.size());
+
+    auto add = [&out_str](boost::string_ref part)
+    {
+        out_str.append(part.data(), part.size());
+    };
+
+    // Book name
+    add(name_beg); add(descr.name); add(name_end);
+    // Average rating
+    add(average); add(descr.average); add(br);
+    // Votes
+    add(votes); add(descr.votes); add(br);
+    // Description
+    add(descr.summary); add(br);
+    // Link to book's page
+    add(link_beg); add(id); add(link_end);
+} // !void format_descr(...)
@@ -0,0 +1,50 @@
+#ifndef DESCR_PARSER_H
+#define DESCR_PARSER_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Elements of description page in one pass
+#include "tag_index.h"
+#include <string>
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Parts of description are slices of page, without copy
+#include <boost/utility/string_ref.hpp>
+
+#endif // Q_MOC_RUN
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Parts of book's description
+// They point into page, so page must live while they are used
+struct book_descr
+{
+    boost::string_ref name;
+    boost::string_ref average;
+    boost::string_ref votes;
+    // With its tags
+    boost::string_ref summary;
+}; // !struct book_descr
+
+// Get book's description from book page
+// index is built for page, it is reused between pages
+// Return false if page has no description
+bool parse_for_descr(boost::string_ref page, tag_index &index,
+                     book_descr &out_descr);
+
+// First element with tag and class after in_beg_pos,
+// with its tags if "with" == true, or empty slice
+boost::string_ref find_by_tag(const tag_index &index,
+                              const char *tag, const char *cls,
+                              size_t &in_beg_pos, bool with);
+
+// Write description of book with id as html
+// out_str is allocated at most once
+void format_descr(const book_descr &descr, boost::string_ref id,
+                  std::string &out_str);
+
+#endif // DESCR_PARSER_H
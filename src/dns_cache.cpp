@@ -0,0 +1,107 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dns_cache.h"
+
+// Resolver lives until its handler is called
+#include <memory>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// dns_cache Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+dns_cache::dns_cache(boost::asio::io_service &io_service):
+    io_service(io_service),
+    ttl(300)
+{
+} // !dns_cache::dns_cache(...)
+
+// How long endpoints are fresh
+void dns_cache::set_ttl(std::chrono::seconds ttl)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->ttl = ttl;
+} // !void dns_cache::set_ttl(...)
+
+// Endpoints of host:port
+// Wait for lookup only if there is nothing cached
+dns_cache::endpoints dns_cache::resolve(const std::string &host,
+                                        const std::string &port)
+{
+    const std::string key = host + ':' + port;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it != entries.end() && it->second.eps.size())
+        {
+            // Stale, but still good until refreshed
+            if (it->second.expires < clock::now() && !it->second.refreshing)
+            {
+                it->second.refreshing = true;
+                io_service.post([this, host, port]()
+                {
+                    async_refresh(host, port);
+                });
+            }
+            return it->second.eps;
+        }
+    }
+
+    // Nothing cached, so wait for lookup
+    boost::asio::ip::tcp::resolver resolver(io_service);
+    auto it = resolver.resolve(boost::asio::ip::tcp::resolver::query(host,
+                                                                     port));
+    endpoints eps(it, decltype(it)());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entry &ent = entries[key];
+    ent.eps = eps;
+    ent.expires = clock::now() + ttl;
+    return eps;
+} // !dns_cache::endpoints dns_cache::resolve(...)
+
+// Forget everything
+void dns_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // Background refresh will fill entry again
+    for (auto i = entries.begin(); i != entries.end(); )
+    {
+        if (i->second.refreshing) ++i;
+        else i = entries.erase(i);
+    }
+} // !void dns_cache::clear()
+
+// !dns_cache Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// dns_cache Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Lookup host:port in background and update entry
+void dns_cache::async_refresh(const std::string &host, const std::string &port)
+{
+    const std::string key = host + ':' + port;
+    auto resolver = std::make_shared<boost::asio::ip::tcp::resolver>(io_service);
+    resolver->async_resolve(boost::asio::ip::tcp::resolver::query(host, port),
+        [this, key, resolver](const boost::system::error_code &ec,
+                              boost::asio::ip::tcp::resolver::iterator it)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entry &ent = entries[key];
+        ent.refreshing = false;
+        // Lookup failed - keep the last good endpoints
+        // and try again on next resolve
+        if (ec || it == boost::asio::ip::tcp::resolver::iterator()) return;
+        ent.eps.assign(it, boost::asio::ip::tcp::resolver::iterator());
+        ent.expires = clock::now() + ttl;
+    });
+} // !void dns_cache::async_refresh(...)
+
+// !dns_cache Private functions
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,75 @@
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Cache is shared between worker threads
+#include <mutex>
+// Time to live of endpoints
+#include <chrono>
+// Endpoints of every host
+#include <map>
+#include <vector>
+#include <string>
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Network:
+#include <boost/asio.hpp>
+
+#endif // Q_MOC_RUN
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Resolved endpoints of every host:port
+// Expired endpoints are still used while they are refreshed in background,
+// and if lookup fails, the last good ones are used.
+// Background refresh needs io_service to be run by somebody.
+class dns_cache
+{
+public:
+    typedef std::vector<boost::asio::ip::tcp::endpoint> endpoints;
+    typedef std::chrono::steady_clock clock;
+
+public:
+    explicit dns_cache(boost::asio::io_service &io_service);
+
+    // How long endpoints are fresh
+    void set_ttl(std::chrono::seconds ttl);
+
+    // Endpoints of host:port
+    // Wait for lookup only if there is nothing cached
+    endpoints resolve(const std::string &host, const std::string &port);
+
+    // Forget everything
+    void clear();
+
+private:
+    // Endpoints of one host:port
+    struct entry
+    {
+        entry(): refreshing(false) {}
+        endpoints eps;
+        clock::time_point expires;
+        bool refreshing;
+    };
+
+private:
+    // Lookup host:port in background and update entry
+    void async_refresh(const std::string &host, const std::string &port);
+
+private:
+    boost::asio::io_service &io_service;
+
+    std::mutex mutex;
+
+    // host:port - endpoints
+    std::map<std::string, entry> entries;
+
+    std::chrono::seconds ttl;
+}; // !class dns_cache
+
+#endif // DNS_CACHE_H
@@ -0,0 +1,935 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "engine.h"
+
+// Description of book from its page
+#include "descr_parser.h"
+
+// Replace algorithm
+#include <boost/algorithm/string.hpp>
+// Settings are read from XML
+#include <boost/property_tree/xml_parser.hpp>
+
+// Load\save settings, lists, etc.
+#include <fstream>
+#include <ctime>
+// Text of errno from list writer
+#include <system_error>
+// Ids of records not written yet
+#include <cstdlib>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// engine Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+engine::engine(const std::string &log_filename):
+    logs(log_filename),
+    tasks(io_service),
+    tasks_token(std::make_shared<cancel_token>()),
+    dns(io_service),
+    conns(io_service, dns),
+    stats(io_service),
+    versions(0),
+    excl(std::make_shared<excl_snapshot>()),
+    excl_reloading(false),
+    excl_lists(std::make_shared<std::vector<excl_list>>())
+{
+    // Until settings are loaded
+    tasks.start(std::thread::hardware_concurrency());
+
+    // Books stay excluded in memory, so lost records must be seen
+    // Error goes to status bar through log's summary
+    lists_writer.set_error_handler([this](const std::string &filename,
+                                          int error)
+    {
+        logs.write(logger::error, "Exclude lists: Write failed, will retry",
+                   logger::field("file", filename) +
+                   logger::field("error",
+                                 std::generic_category().message(error)));
+    });
+} // !engine::engine(...)
+
+//
+engine::~engine()
+{
+    cancel_tasks();
+
+    // Background operations use dns and conns
+    tasks.stop();
+} // !engine::~engine()
+
+// Load settings or create default
+void engine::load_settings(const std::string &username)
+{
+    cancel_tasks();
+
+    this->username = username;
+
+    logs.write(logger::info, "XML: Loading");
+
+    std::shared_ptr<settings> cfg = read_settings(true);
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex);
+        cfg->version = ++versions;
+        std::atomic_store(&prefs, std::shared_ptr<const settings>(cfg));
+    }
+
+    logs.write(logger::info, "XML: Loaded",
+               logger::field("version", cfg->version));
+
+    // All tasks are finished, so number of threads can be changed
+    tasks.start(cfg->tasks.threads);
+
+    // Endpoints and connections of previous site
+    dns.clear();
+    conns.clear();
+
+    // Descriptions of this user
+    descrs.open("./rsrc/" + username + ".descr.dat",
+                cfg->book_info.cache_ttl, cfg->book_info.cache_size);
+
+    // Listing pages of this user, received by previous searches
+    crawl.open("./rsrc/" + username + ".crawl.dat");
+
+    apply_settings(*cfg, nullptr);
+
+    load_lists();
+
+    async_warm_conns();
+} // !void engine::load_settings(...)
+
+// Read settings file again on worker thread and publish new version
+void engine::async_reload_settings()
+{
+    tasks.post([this]()
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex);
+        std::shared_ptr<settings> cfg;
+        try
+        {
+            cfg = read_settings(false);
+        }
+        catch (std::exception &ref)
+        {
+            logs.write(logger::error, "XML: Reload failed, settings are kept",
+                       logger::field("error", ref.what()));
+            return;
+        }
+
+        const std::shared_ptr<const settings> old = std::atomic_load(&prefs);
+        cfg->version = ++versions;
+        // New tasks get this version, running ones keep old
+        std::atomic_store(&prefs, std::shared_ptr<const settings>(cfg));
+        apply_settings(*cfg, old.get());
+
+        logs.write(logger::info, "XML: Reloaded",
+                   logger::field("version", cfg->version));
+    });
+} // !void engine::async_reload_settings()
+
+// Read lists file again on worker thread and publish new lists
+void engine::async_reload_lists(std::function<void ()> on_loaded)
+{
+    tasks.post([this, on_loaded]()
+    {
+        try
+        {
+            load_lists();
+        }
+        catch (std::exception &ref)
+        {
+            logs.write(logger::error, "Exclude lists: Reload failed",
+                       logger::field("error", ref.what()));
+            return;
+        }
+        if (on_loaded) on_loaded();
+    });
+} // !void engine::async_reload_lists(...)
+
+// Files of user, watched for reload
+std::string engine::settings_filename() const
+{
+    return "./rsrc/" + username + ".pref.xml";
+} // !std::string engine::settings_filename() const
+
+//
+std::string engine::lists_filename() const
+{
+    return "./rsrc/lists/" + username + ".lists.txt";
+} // !std::string engine::lists_filename() const
+
+// Wait for threads to finish
+// This makes possible to change settings, cookie, etc without reload
+bool engine::wait_for_tasks()
+{
+
+    logs.write(logger::info, "General: Waiting for tasks to finish");
+
+    bool ok = true;
+    tasks.wait_all([this, &ok](size_t remain, std::exception_ptr error)
+    {
+        logs.write(logger::info, "General: Tasks remain",
+                   logger::field("remain", remain));
+
+        // Display exception what() in status bar, if any
+        if (!error) return;
+        ok = false;
+        try
+        {
+            std::rethrow_exception(error);
+        }
+        catch (task_cancelled &)
+        {
+            logs.write(logger::warning, "General: Task cancelled");
+        }
+        catch (std::exception &ref)
+        {
+            logs.write(logger::error, std::string("Fail: ") + ref.what());
+        }
+        catch (...)
+        {
+            logs.write(logger::error, "Fail: Unknown");
+        }
+    });
+
+    logs.write(logger::info, "General: Tasks finished");
+    return ok;
+} // !bool engine::wait_for_tasks()
+
+// Cancel running tasks and wait for them
+void engine::cancel_tasks()
+{
+    tasks_token->cancel();
+    wait_for_tasks();
+    tasks_token = std::make_shared<cancel_token>();
+} // !void engine::cancel_tasks()
+
+// Token for new task, with deadline from settings
+cancel_token::ptoken engine::new_task_token()
+{
+    cancel_token::ptoken token = tasks_token->make_child();
+    const std::shared_ptr<const settings> cfg = pref();
+    if (cfg && cfg->tasks.deadline.count())
+    {
+        token->set_deadline(io_service, cfg->tasks.deadline);
+    }
+    return token;
+} // !cancel_token::ptoken engine::new_task_token()
+
+// Connect, send auth info, return cookie made from reply
+std::string engine::authorize(const std::string &login,
+                              const std::string &password,
+                              cancel_token::ptoken token)
+{
+    logs.write(logger::info, "Authorize: Starting");
+
+    // The whole task uses one version of settings
+    const std::shared_ptr<const settings> cfg = pref();
+
+    // POST request with $login and $password from user input if any
+    std::string post_req;
+    cfg->auth.post.render(post_req, {login, password});
+
+    // GET request with $Content-Length - size of post request
+    std::string get_req;
+    cfg->auth.get.render(get_req, {decimal(post_req.size()).str()});
+
+    // Add POST to GET
+    get_req+=post_req;
+
+    logs.write(logger::info, "Authorize: Connecting");
+
+    // Get reply from server with user id, user hash and phpsid
+    std::string body;
+    http_reply reply([&body](const char *data, size_t size)
+    {
+        body.append(data, size);
+    });
+    // Send GET request with POST data from above
+    request(*cfg, get_req, reply, token.get(), metrics::authorize);
+
+    logs.write(logger::info, "Authorize: Parsing reply");
+    const metrics::clock::time_point parse_start = metrics::clock::now();
+
+    // Cookies are in headers, but search body too
+    const std::string reply_str = reply.head() + body;
+
+    // Make cookie
+    std::string new_cookie("Cookie:");
+    // Add to cookie user_id from reply if any
+    add_cookie(new_cookie, reply_str, cfg->auth.user_id);
+    // Add to cookie user_hash from reply if any
+    add_cookie(new_cookie, reply_str, cfg->auth.user_hash);
+    // Add to cookie PHPSID from reply if any
+    add_cookie(new_cookie, reply_str, cfg->auth.phpsid);
+
+    stats.record(metrics::authorize, metrics::parse,
+                 metrics::clock::now() - parse_start);
+    logs.write(logger::info, "Authorize: Parsed");
+
+    return new_cookie;
+} // !std::string engine::authorize(...)
+
+// Send GET with cookie
+// Get reply and parse it for unread books
+// Repeat until count(unread books) < num from xml settings
+void engine::get_unread(cancel_token::ptoken token,
+                        const book_handler &on_book, size_t num)
+{
+    logs.write(logger::info, "Unread: Starting");
+
+    // The whole search uses one version of settings
+    const std::shared_ptr<const settings> cfg = pref();
+
+    // Start searching from this page
+    size_t page_num = cfg->unread.start_page;
+    // Minimum desired number of unread books
+    if (!num) num = cfg->unread.num;
+
+    // Pages to fetch at once, 1 - one by one
+    const size_t parallel = cfg->unread.parallel;
+
+    // Pages received by this run before crash or cancel are used as is
+    const std::time_t run_start = crawl.begin_run(cfg->unread.resume_ttl);
+
+    // count - unread books. num - desired.
+    size_t count(0);
+
+    // Book from page or crawl state
+    auto add_book = [&](unsigned long long id, const char *title, size_t size)
+    {
+        // Is this a book from exclude lists?
+        if (is_excluded(id)) return;
+        on_book(id, title, size);
+        ++count;
+    };
+
+    // Page isn't changed since it was received
+    auto add_stored = [&](const crawl_state::page &stored)
+    {
+        for (const crawl_state::book &b : stored.books)
+        {
+            add_book(b.id, b.title.data(), b.title.size());
+        }
+    };
+
+    // Received page with all its books, excluded too
+    crawl_state::page received;
+
+    // Page is parsed piece by piece, without saving
+    unread_parser parser([&](unsigned long long id,
+                             const char *title, size_t size)
+    {
+        crawl_state::book b;
+        b.id = id;
+        b.title.assign(title, size);
+        received.books.push_back(std::move(b));
+        add_book(id, title, size);
+    });
+
+    // Save received page for next searches
+    auto save_page = [&](size_t num, const http_reply &reply)
+    {
+        const unsigned status = reply.status();
+        if (status != 200)
+        {
+            logs.write(logger::warning, "Unread: Server replied",
+                       logger::field("status", status));
+            return;
+        }
+        received.fetched = std::time(nullptr);
+        const boost::string_ref etag = reply.header("etag");
+        const boost::string_ref last_modified = reply.header("last-modified");
+        received.etag.assign(etag.data(), etag.size());
+        received.last_modified.assign(last_modified.data(),
+                                      last_modified.size());
+        crawl.put(num, received);
+    };
+
+    if (parallel == 1)
+    {
+        // Request of every page is written here
+        std::string get_req;
+
+        // Time of parsing, between pieces of body
+        metrics::clock::duration parse_time;
+
+        // Body of page received before is kept and parsed only
+        // if its hash is changed, new page is parsed as it arrives
+        bool buffered = false;
+        std::string body;
+
+        // Parse body as it arrives
+        auto parse = [&](const char *data, size_t size)
+        {
+            const metrics::clock::time_point start = metrics::clock::now();
+            parser.feed(data, size);
+            parse_time += metrics::clock::now() - start;
+        };
+        http_reply reply([&](const char *data, size_t size)
+        {
+            token->check();
+            received.hash = crawl_state::hash_body(data, size, received.hash);
+            if (buffered) body.append(data, size);
+            else parse(data, size);
+        });
+
+        while (count < num)
+        {
+            token->check();
+
+            crawl_state::page stored;
+            const bool known = crawl.get(page_num, stored);
+            if (known && stored.fetched > run_start)
+            {
+                logs.write(logger::info, "Unread: Page resumed",
+                           logger::field("page", page_num));
+                add_stored(stored);
+                ++page_num;
+                continue;
+            }
+
+            // Every page is a new document
+            parser.reset();
+            reply.reset();
+            received = crawl_state::page();
+            received.hash = crawl_state::hash_seed;
+            parse_time = metrics::clock::duration::zero();
+            buffered = known;
+            body.clear();
+
+            // Send GET request with cookie and page number,
+            // conditional if page was received before
+            // Get Reply and parse it
+            render_page(*cfg, get_req, page_num);
+            if (known)
+                add_validators(get_req, stored.etag, stored.last_modified);
+            request(*cfg, get_req, reply, token.get(), metrics::unread);
+
+            if (known && (reply.status() == 304 ||
+                          (reply.status() == 200 &&
+                           received.hash == stored.hash)))
+            {
+                // Page isn't parsed again
+                add_stored(stored);
+                crawl.touch(page_num);
+            }
+            else
+            {
+                if (buffered) parse(body.data(), body.size());
+                stats.record(metrics::unread, metrics::parse, parse_time);
+                save_page(page_num, reply);
+            }
+            ++page_num;
+        }// !while (...)
+
+        crawl.end_run();
+        return;
+    }
+
+    // Page of window: stored or requested by task
+    struct window_page
+    {
+        size_t num;
+        bool known;
+        // Stored page of this run is used without request
+        bool resumed;
+        crawl_state::page stored;
+        // Not valid if stored page is used without request
+        std::future<buffer_pool::lease> reply;
+    };
+
+    // Download window of pages at once,
+    // but parse them in page order, so list has the same order
+    std::vector<window_page> window;
+    for (size_t pages(0); count < num; )
+    {
+        token->check();
+
+        // Don't ask for many pages, if few books remain
+        // pages/count - pages for one unread book
+        size_t size = parallel;
+        if (count)
+        {
+            size = ((num-count)*pages + count-1)/count;
+            if (size > parallel) size = parallel;
+        }
+
+        // Requests of window, cancelled when enough books are found
+        const cancel_token::ptoken window_token = token->make_child();
+
+        window.clear();
+        for (size_t i(0); i < size; ++i)
+        {
+            window_page page;
+            page.num = page_num++;
+            page.known = crawl.get(page.num, page.stored);
+            page.resumed = page.known && page.stored.fetched > run_start;
+            if (!page.resumed)
+            {
+                const size_t num = page.num;
+                const std::string etag = page.stored.etag;
+                const std::string last_modified = page.stored.last_modified;
+                page.reply = tasks.submit([this, cfg, num, etag,
+                                           last_modified, window_token]()
+                {
+                    // Request, reply and body of page, merge returns them
+                    buffer_pool::lease buf = buffers.get();
+                    window_token->check();
+                    render_page(*cfg, buf->request, num);
+                    add_validators(buf->request, etag, last_modified);
+                    request(*cfg, buf->request, buf->reply,
+                            window_token.get(), metrics::unread);
+                    return buf;
+                });
+            }
+            window.push_back(std::move(page));
+        }
+
+        // Tasks refer to engine, so they are waited for,
+        // but they aren't downloading any more
+        auto drop_window = [this, &window, &window_token]()
+        {
+            window_token->cancel();
+            for (auto &page : window)
+            {
+                // Resumed or already merged
+                if (!page.reply.valid()) continue;
+                try
+                {
+                    tasks.get(page.reply);
+                }
+                catch (std::exception &)
+                {
+                    // Page isn't needed, so its failure too
+                }
+            }
+        };
+
+        // Ordered merge, the rest of window isn't needed if enough found
+        try
+        {
+            for (auto &page : window)
+            {
+                if (count >= num) break;
+
+                buffer_pool::lease fetched;
+                if (!page.resumed) fetched = tasks.get(page.reply);
+                ++pages;
+                token->check();
+
+                if (page.resumed)
+                {
+                    logs.write(logger::info, "Unread: Page resumed",
+                               logger::field("page", page.num));
+                    add_stored(page.stored);
+                    continue;
+                }
+
+                const std::string &body = fetched->body;
+                const unsigned status = fetched->reply.status();
+                const std::uint64_t hash =
+                        crawl_state::hash_body(body.data(), body.size());
+                if (page.known && (status == 304 ||
+                                   (status == 200 && hash == page.stored.hash)))
+                {
+                    // Page isn't parsed again
+                    add_stored(page.stored);
+                    crawl.touch(page.num);
+                    continue;
+                }
+
+                const metrics::clock::time_point start = metrics::clock::now();
+                received = crawl_state::page();
+                received.hash = hash;
+                parser.reset();
+                parser.feed(body.data(), body.size());
+                stats.record(metrics::unread, metrics::parse,
+                             metrics::clock::now() - start);
+                save_page(page.num, fetched->reply);
+            }
+        }
+        catch (...)
+        {
+            // Failed page or cancel, the rest of window is dropped too
+            drop_window();
+            throw;
+        }
+        drop_window();
+    }// !for (...)
+
+    crawl.end_run();
+} // !void engine::get_unread(...)
+
+// Get book's description from site and save it to cache
+bool engine::get_book_info(unsigned long long id, std::string &out_descr,
+                           cancel_token::ptoken token)
+{
+    // Book id
+    const decimal id_str(id);
+
+    logs.write(logger::info, "Book info: Getting description");
+
+    const std::shared_ptr<const settings> cfg = pref();
+
+    // Request, reply, body and index of page from previous requests
+    buffer_pool::lease buf = buffers.get();
+
+    // GET request with $id
+    cfg->book_info.get.render(buf->request, {id_str.str()});
+    // Send GET request, body is appended to buf->body
+    request(*cfg, buf->request, buf->reply, token.get(), metrics::book_info);
+
+    logs.write(logger::info, "Book info: Parsing description");
+
+    // Parts of description are slices of body
+    const metrics::clock::time_point parse_start = metrics::clock::now();
+    book_descr descr;
+    const bool found = parse_for_descr(buf->body, buf->index, descr);
+    stats.record(metrics::book_info, metrics::parse,
+                 metrics::clock::now() - parse_start);
+    out_descr.clear();
+    if (!found) return false;
+
+    format_descr(descr, id_str.str(), out_descr);
+    descrs.put(id, out_descr);
+    return true;
+} // !bool engine::get_book_info(...)
+
+// Book's description from disk cache
+// Return true if it must be requested from site
+bool engine::load_cached_info(unsigned long long id, std::string &out_descr)
+{
+    bool stale(false);
+    if (!descrs.get(id, out_descr, stale)) return true;
+    return stale;
+} // !bool engine::load_cached_info(...)
+
+// Is this a book from exclude lists?
+bool engine::is_excluded(unsigned long long id) const
+{
+    return std::atomic_load(&excl)->contains(id);
+} // !bool engine::is_excluded(...)
+
+// Add books to exclude list file and exclude them at once
+void engine::exclude(const std::string &list_filename,
+                     const std::vector<excl_book> &books)
+{
+    if (books.empty()) return;
+
+    static const std::string session = std::to_string(time(nullptr));
+    // Only other exclude or publishing of reloaded lists waits here
+    std::lock_guard<std::mutex> lock(excl_mutex);
+    // Records of all books, written in background
+    std::string records;
+    // New exclude snapshot with these books
+    std::shared_ptr<excl_snapshot> snapshot =
+            std::make_shared<excl_snapshot>(*std::atomic_load(&excl));
+    for (const excl_book &book : books)
+    {
+        records += std::to_string(book.id);
+        records += ';';
+        records += book.title;
+        records += " @ ";
+        records += session;
+        records += '\n';
+        snapshot->added.emplace(book.id);
+        // Lists being reloaded may be read before these records
+        if (excl_reloading) excl_pending.push_back(book.id);
+    }
+
+    lists_writer.append(list_filename, records);
+    // Running searches skip these books at once
+    publish_excl(snapshot);
+} // !void engine::exclude(...)
+
+// Write stats to file from settings
+void engine::export_metrics()
+{
+    const std::shared_ptr<const settings> cfg = pref();
+    if (cfg && cfg->metrics.file.size()) stats.write_file(cfg->metrics.file);
+} // !void engine::export_metrics()
+
+// !engine Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// engine Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Read settings file, create it from default if it doesn't exist
+std::shared_ptr<settings> engine::read_settings(bool create_default)
+{
+    const std::string xml_filename = settings_filename();
+
+    boost::property_tree::ptree xml_pref;
+    try
+    {
+        boost::property_tree::read_xml(xml_filename, xml_pref);
+    }
+    catch (boost::property_tree::xml_parser_error &)
+    {
+        if (!create_default) throw;
+
+        logs.write(logger::info, "XML: File not found, create default ");
+
+        std::ofstream(xml_filename)
+                << std::ifstream("./rsrc/.pref.xml").rdbuf();
+
+        logs.write(logger::info, "XML: Default file created ");
+
+        boost::property_tree::read_xml(xml_filename, xml_pref);
+    }
+
+    // Values and requests are compiled once, not looked up by every task
+    return std::make_shared<settings>(xml_pref);
+} // !std::shared_ptr<settings> engine::read_settings(...)
+
+// Pass settings to dns, conns, etc
+void engine::apply_settings(const settings &cfg, const settings *old)
+{
+    // Endpoints of site are fresh this long
+    dns.set_ttl(cfg.site.dns_ttl);
+
+    // Connection limits for this site
+    conns.set_limits(cfg.site.max_conn, cfg.site.idle_timeout);
+
+    // Excluded books are written in batches
+    lists_writer.set_limits(cfg.lists.batch_size, cfg.lists.batch_delay);
+
+    // Stats endpoint for Prometheus, only on loopback
+    if (!old || old->metrics.port != cfg.metrics.port)
+        stats.serve(cfg.metrics.port);
+
+    // Save exchanges with site for replay server, if directory is set
+    if (!old || old->record.dir != cfg.record.dir)
+        exchanges.open(cfg.record.dir);
+} // !void engine::apply_settings(...)
+
+void engine::load_lists()
+{
+
+    logs.write(logger::info, "Exclude lists: Loading");
+
+    // Load lists file
+    const std::string all_lists_filename = lists_filename();
+    std::ifstream all_lists_file(all_lists_filename);
+
+    // Create default if this doesn't exist
+    if (!all_lists_file.is_open())
+    {
+        logs.write(logger::info, "Exclude lists: File not found, creating default");
+
+        all_lists_file.close();
+        all_lists_file.clear();
+
+        std::ofstream(all_lists_filename)
+                << std::ifstream("./rsrc/lists/.lists.txt").rdbuf();
+
+        all_lists_file.open(all_lists_filename);
+
+        logs.write(logger::info, "Exclude lists: Default file created");
+    }
+
+    // Other reload waits, exclude() doesn't
+    std::lock_guard<std::mutex> lock(reload_mutex);
+    {
+        // Books excluded from now on are merged into new snapshot
+        std::lock_guard<std::mutex> excl_lock(excl_mutex);
+        excl_reloading = true;
+        excl_pending.clear();
+    }
+
+    // Make new id set without locks
+    // Books excluded before are in lists files after this
+    lists_writer.flush();
+    std::shared_ptr<excl_snapshot> snapshot = std::make_shared<excl_snapshot>();
+    std::shared_ptr<std::vector<excl_list>> new_lists =
+            std::make_shared<std::vector<excl_list>>();
+
+    // Records, that failed to be written and wait for retry, aren't
+    // in files, so their books stay excluded by id
+    lists_writer.unwritten([&snapshot](const std::string &records)
+    {
+        // Every record is "id;title @ session\n"
+        for (size_t pos(0); pos < records.size(); ++pos)
+        {
+            snapshot->added.emplace(strtoull(records.c_str()+pos, nullptr, 10));
+            pos = records.find('\n', pos);
+            if (pos == std::string::npos) break;
+        }
+    });
+
+    excl_list list;
+
+    try
+    {
+        // Add every file in ...lists.txt
+        while (all_lists_file)
+        {
+            // Get list's filename
+            getline(all_lists_file, list.filename, ';');
+            boost::replace_first(list.filename, "$username", username);
+            // Get list's name
+            getline(all_lists_file, list.name);
+            // if (end)
+            if (!all_lists_file) break;
+
+            // Map book id from exclude list, parse it only if it is changed
+            std::shared_ptr<excl_index> index = std::make_shared<excl_index>();
+            index->open(list.filename);
+            snapshot->lists.push_back(index);
+
+            new_lists->push_back(list);
+        }
+    }
+    catch (...)
+    {
+        // Old snapshot stays, it already has books excluded meanwhile
+        std::lock_guard<std::mutex> excl_lock(excl_mutex);
+        excl_reloading = false;
+        excl_pending.clear();
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> excl_lock(excl_mutex);
+        snapshot->added.insert(excl_pending.begin(), excl_pending.end());
+        excl_reloading = false;
+        excl_pending.clear();
+
+        publish_excl(snapshot);
+        std::atomic_store(&excl_lists,
+                          std::shared_ptr<const std::vector<excl_list>>(new_lists));
+    }
+
+    logs.write(logger::info, "Exclude lists: Loaded");
+} // !void engine::load_lists()
+
+// Open connections to site in advance
+void engine::async_warm_conns()
+{
+    const std::shared_ptr<const settings> cfg = pref();
+    if (!cfg->site.warm_conn) return;
+
+    tasks.post([this, cfg]()
+    {
+        conns.warm(cfg->site.addr, cfg->site.port, cfg->site.warm_conn);
+    });
+} // !void engine::async_warm_conns()
+
+// Send request to site from settings and read reply
+// with connection from pool, time of its phases goes to stats
+void engine::request(const settings &cfg, const std::string &req,
+                     http_reply &reply, cancel_token *token,
+                     metrics::path path)
+{
+    // Raw reply for replay server
+    // Authorize has login and password, so it is never recorded
+    std::string raw;
+    const bool record = exchanges.is_open() && path != metrics::authorize;
+    if (record)
+    {
+        reply.set_raw_handler([&raw](const char *data, size_t size)
+        {
+            raw.append(data, size);
+        });
+    }
+
+    request_timing timing;
+    try
+    {
+        http_request(conns, cfg.site.addr, cfg.site.port,
+                     req, reply, token, &timing);
+    }
+    catch (...)
+    {
+        // Handler refers to raw
+        reply.set_raw_handler(http_reply::body_handler());
+        throw;
+    }
+
+    if (record)
+    {
+        reply.set_raw_handler(http_reply::body_handler());
+        exchanges.save(req, raw);
+    }
+
+    // Reused connection has no lookup and connect
+    if (timing.connect != request_timing::clock::duration::zero())
+    {
+        stats.record(path, metrics::dns, timing.dns);
+        stats.record(path, metrics::connect, timing.connect);
+    }
+    stats.record(path, metrics::first_byte, timing.first_byte);
+    stats.record(path, metrics::body, timing.body);
+} // !void engine::request(...)
+
+// Request for listing page
+void engine::render_page(const settings &cfg, std::string &out,
+                         size_t page_num)
+{
+    const decimal page(page_num);
+    cfg.unread.get.render(out, {cookie, page.str()});
+
+    logs.write(logger::info, "Unread: Page processing",
+               logger::field("page", page_num));
+} // !void engine::render_page(...)
+
+// Make exclude book's id visible to running and new tasks
+void engine::publish_excl(std::shared_ptr<const excl_snapshot> snapshot)
+{
+    // Tasks keep old snapshot until they load this one
+    std::atomic_store(&excl, snapshot);
+} // !void engine::publish_excl(...)
+
+// Add If-None-Match and If-Modified-Since after request line
+void engine::add_validators(std::string &req, const std::string &etag,
+                            const std::string &last_modified)
+{
+    if (etag.empty() && last_modified.empty()) return;
+    const size_t line_end = req.find('\n');
+    if (line_end == req.npos) return;
+
+    // The same line end as in template
+    const char *eol = line_end && req[line_end-1] == '\r' ? "\r\n" : "\n";
+    std::string headers;
+    if (etag.size())
+    {
+        headers += "If-None-Match: ";
+        headers += etag;
+        headers += eol;
+    }
+    if (last_modified.size())
+    {
+        headers += "If-Modified-Since: ";
+        headers += last_modified;
+        headers += eol;
+    }
+    req.insert(line_end+1, headers);
+} // !void engine::add_validators(...)
+
+// Add to out_str cookie sequence from src,
+// that begins with beg_req and end with ';'
+void engine::add_cookie(std::string &out_str, const std::string &src,
+                        const std::string &beg_req)
+{
+    auto beg_pos = src.find(beg_req);
+    if (beg_pos!=src.npos)
+    {
+        auto end_pos = src.find(';', beg_pos);
+        if (end_pos!=src.npos)
+        {
+            out_str+=' ';
+            out_str.append(src, beg_pos, ++end_pos-beg_pos);
+        }
+    }
+} // !void engine::add_cookie(...)
+
+// !engine Private functions
+///////////////////////////////////////////////////////////////////////////////
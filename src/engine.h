@@ -0,0 +1,276 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Network:
+#include <boost/asio.hpp>
+
+#endif // Q_MOC_RUN
+
+// Application preferences, compiled once
+#include "settings.h"
+
+// Reads HTTP reply until its real end
+#include "http_reply.h"
+// Keep-alive connections to site
+#include "conn_pool.h"
+// Endpoints of site without lookup every time
+#include "dns_cache.h"
+// Worker threads running io_service
+#include "task_pool.h"
+// Stop stale tasks without waiting for them
+#include "cancel_token.h"
+// Finds unread books in listing as it arrives
+#include "unread_parser.h"
+// Descriptions of books between sessions
+#include "descr_cache.h"
+// Listing pages of previous searches
+#include "crawl_state.h"
+// Buffers of requests are reused
+#include "buffer_pool.h"
+// Ids of exclude lists without parsing them at startup
+#include "excl_index.h"
+// Appends to exclude lists in background
+#include "list_writer.h"
+// Log file and status bar messages
+#include "logger.h"
+// Time of request phases
+#include "metrics.h"
+// Saves exchanges with site for replay server
+#include "recorder.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+// Reload of settings and lists
+#include <functional>
+#include <mutex>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Everything IUNB does with site and files, without GUI
+// Results are passed to handlers on the calling or worker threads,
+// so it is used by window and by command line tool the same way.
+// Settings are loaded and tasks are cancelled by one controlling thread.
+// Settings and lists are published as immutable versions: reload swaps
+// them, running tasks keep the version they started with.
+class engine
+{
+public:
+    // Receives id and title (utf-8) of unread book, which isn't excluded
+    typedef unread_parser::book_handler book_handler;
+
+    // Exclude list from $username.lists.txt
+    struct excl_list
+    {
+        std::string filename;
+        // Name shown to user
+        std::string name;
+    };
+
+    // Book to add to exclude list
+    struct excl_book
+    {
+        unsigned long long id;
+        std::string title;
+    };
+
+public:
+    explicit engine(const std::string &log_filename = "./rsrc/iunb.txt");
+
+    // Cancel and wait for tasks
+    ~engine();
+
+    // Load settings and exclude lists of user or create default
+    // Running tasks are cancelled
+    void load_settings(const std::string &username);
+
+    // Read settings file again on worker thread and publish new version
+    // Broken file is logged and the previous version is kept
+    // Number of threads and description cache change on next load_settings
+    void async_reload_settings();
+
+    // Read lists file again on worker thread and publish new lists,
+    // then on_loaded is called by worker thread
+    void async_reload_lists(std::function<void ()> on_loaded);
+
+    // Files of user, watched for reload
+    std::string settings_filename() const;
+    std::string lists_filename() const;
+
+    // Settings are loaded
+    bool is_loaded() const { return static_cast<bool>(pref()); }
+
+    // The latest settings
+    std::shared_ptr<const settings> pref() const
+    { return std::atomic_load(&prefs); }
+
+    // Exclude lists of user, the latest loaded
+    std::shared_ptr<const std::vector<excl_list>> lists() const
+    { return std::atomic_load(&excl_lists); }
+
+    // Wait for tasks to finish, their exceptions go to log
+    // Return false if some task failed
+    bool wait_for_tasks();
+
+    // Cancel running tasks and wait for them
+    void cancel_tasks();
+
+    // Token for new task, with deadline from settings
+    cancel_token::ptoken new_task_token();
+
+    // Connect, send auth info, return cookie made from reply
+    std::string authorize(const std::string &login,
+                          const std::string &password,
+                          cancel_token::ptoken token);
+
+    // Cookie for next requests, tasks must be finished
+    void set_cookie(const std::string &new_cookie) { cookie = new_cookie; }
+
+    // Send GET with cookie
+    // Get reply and parse it for unread books
+    // Repeat until count(unread books) < num, 0 - num from xml settings
+    // Pages received before are asked with conditional GET, and pages
+    // of unfinished search are used without request
+    void get_unread(cancel_token::ptoken token, const book_handler &on_book,
+                    size_t num = 0);
+
+    // Get book's description from site and save it to cache
+    // Return false if page has no description
+    bool get_book_info(unsigned long long id, std::string &out_descr,
+                       cancel_token::ptoken token);
+
+    // Book's description from disk cache
+    // Return true if it must be requested from site
+    bool load_cached_info(unsigned long long id, std::string &out_descr);
+
+    // Is this a book from exclude lists?
+    bool is_excluded(unsigned long long id) const;
+
+    // Add books to exclude list file and exclude them at once
+    void exclude(const std::string &list_filename,
+                 const std::vector<excl_book> &books);
+
+    // Write stats to file from settings
+    void export_metrics();
+
+    // Tasks are posted here
+    task_pool &pool() { return tasks; }
+
+    logger &log() { return logs; }
+
+    metrics &timings() { return stats; }
+
+private:
+    // Read settings file, create it from default if it doesn't exist
+    std::shared_ptr<settings> read_settings(bool create_default);
+
+    // Pass settings to dns, conns, etc
+    // old is the previous version, nullptr if user is changed
+    void apply_settings(const settings &cfg, const settings *old);
+
+    // Load exclude lists
+    void load_lists();
+
+    // Open connections to site in advance
+    void async_warm_conns();
+
+    // Send request to site from settings and read reply
+    // with connection from pool, time of its phases goes to stats
+    void request(const settings &cfg, const std::string &req,
+                 http_reply &reply, cancel_token *token, metrics::path path);
+
+    // Request for listing page
+    void render_page(const settings &cfg, std::string &out, size_t page_num);
+
+    // Make exclude book's id visible to running and new tasks
+    void publish_excl(std::shared_ptr<const excl_snapshot> snapshot);
+
+    // Add If-None-Match and If-Modified-Since after request line
+    static void add_validators(std::string &req, const std::string &etag,
+                               const std::string &last_modified);
+
+    // Add to out_str cookie sequence from src,
+    // that begins with beg_req and end with ';'
+    static void add_cookie(std::string &out_str,
+                           const std::string &src,
+                           const std::string &beg_req);
+
+private:
+    // Everybody writes here, so it is destroyed last
+    logger logs;
+
+    // All configuration file's names are made from this string
+    std::string username;
+
+    // Needed for boost IO operations
+    boost::asio::io_service io_service;
+
+    // Runs all tasks and background operations of io_service
+    // Holds exception from worker threads, if any
+    // also I can wait for threads to finish
+    task_pool tasks;
+
+    // Cancelled when running tasks become stale
+    // every task has its own child token
+    cancel_token::ptoken tasks_token;
+
+    // Resolved endpoints of site
+    dns_cache dns;
+
+    // Keep-alive connections shared by all requests
+    conn_pool conns;
+
+    // Time of request phases
+    metrics stats;
+
+    // Saves exchanges with site, if recording is on
+    recorder exchanges;
+
+    // Stores preferences from $username.pref.xml
+    // Published by load and reload, read by tasks with std::atomic_load
+    std::shared_ptr<const settings> prefs;
+    // Number of the latest settings version
+    unsigned versions;
+
+    // Reloads are done one by one
+    std::mutex reload_mutex;
+
+    // Stores auth
+    std::string cookie;
+
+    // Stores book's descriptions on disk
+    descr_cache descrs;
+
+    // Stores listing pages, validators and checkpoint of search
+    crawl_state crawl;
+
+    // Buffers of book info and parallel page requests
+    buffer_pool buffers;
+
+    // Stores book's id to exclude
+    // Published by controlling thread, read by workers with std::atomic_load
+    std::shared_ptr<const excl_snapshot> excl;
+    // Guards publishing of exclude snapshot, held only for a moment,
+    // so exclude() doesn't wait for reload of lists
+    std::mutex excl_mutex;
+    // Reload of lists is reading files, books excluded meanwhile
+    // are kept in excl_pending and merged into its snapshot
+    bool excl_reloading;
+    std::vector<unsigned long long> excl_pending;
+
+    // Exclude list files and their names
+    // Published with exclude snapshot, read with std::atomic_load
+    std::shared_ptr<const std::vector<excl_list>> excl_lists;
+
+    // Writes excluded books to exclude list files
+    list_writer lists_writer;
+}; // !class engine
+
+#endif // ENGINE_H
@@ -0,0 +1,227 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "excl_index.h"
+
+// Read text list and write sidecar
+#include <fstream>
+#include <sstream>
+// Sort ids, binary search
+#include <algorithm>
+// memcmp
+#include <cstring>
+
+// Size and modification time of list, replace sidecar
+#include <boost/filesystem.hpp>
+
+// Read ids in text list
+#include "scan.h"
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Sidecar format
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Changed if format is changed
+    const char idx_magic[8] = {'I', 'U', 'N', 'B', 'I', 'D', 'X', '1'};
+} // !namespace
+
+// !Sidecar format
+///////////////////////////////////////////////////////////////////////////////
+
+
+// excl_index Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+excl_index::excl_index():
+    ids(nullptr),
+    count(0)
+{
+} // !excl_index::excl_index()
+
+// Map sidecar of text list, rebuild it if text list is changed
+// Missing list is empty
+void excl_index::open(const std::string &list_filename)
+{
+    close();
+
+    boost::system::error_code ec;
+    const std::uint64_t list_size = boost::filesystem::file_size(list_filename,
+                                                                 ec);
+    if (ec) return;
+    const std::int64_t list_time =
+            boost::filesystem::last_write_time(list_filename, ec);
+    if (ec) return;
+
+    const std::string idx_filename = list_filename + ".idx";
+    if (is_fresh(idx_filename, list_size, list_time) && map(idx_filename))
+    {
+        return;
+    }
+
+    parse(list_filename, parsed);
+    if (write(idx_filename, parsed, list_size, list_time) &&
+        map(idx_filename))
+    {
+        parsed = std::vector<std::uint64_t>();
+        return;
+    }
+
+    // Sidecar can't be used, so ids stay in memory
+    ids = parsed.data();
+    count = parsed.size();
+} // !void excl_index::open(...)
+
+// Unmap sidecar
+void excl_index::close()
+{
+    region = boost::interprocess::mapped_region();
+    file = boost::interprocess::file_mapping();
+    parsed.clear();
+    ids = nullptr;
+    count = 0;
+} // !void excl_index::close()
+
+// Is id in list?
+bool excl_index::contains(unsigned long long id) const
+{
+    return std::binary_search(ids, ids+count, static_cast<std::uint64_t>(id));
+} // !bool excl_index::contains(...)
+
+// !excl_index Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// excl_index Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Is sidecar made from list with this size and time?
+bool excl_index::is_fresh(const std::string &idx_filename,
+                          std::uint64_t list_size,
+                          std::int64_t list_time) const
+{
+    std::ifstream idx(idx_filename, std::ios::binary);
+    header head;
+    if (!idx.read(reinterpret_cast<char*>(&head), sizeof(head))) return false;
+
+    return !memcmp(head.magic, idx_magic, sizeof(idx_magic)) &&
+            head.list_size == list_size &&
+            head.list_time == list_time;
+} // !bool excl_index::is_fresh(...)
+
+// Parse text list to sorted unique ids
+void excl_index::parse(const std::string &list_filename,
+                       std::vector<std::uint64_t> &out_ids)
+{
+    out_ids.clear();
+
+    // Whole list at once
+    std::ifstream list_file(list_filename, std::ios::binary);
+    std::ostringstream list_buf;
+    list_buf << list_file.rdbuf();
+    const std::string list = list_buf.str();
+
+    // Every line is "id;title @ session"
+    const char *pos = list.data();
+    const char *end = pos+list.size();
+    while (pos != end)
+    {
+        while (pos != end && (*pos==' ' || *pos=='\t' || *pos=='\r')) ++pos;
+
+        unsigned long long id;
+        const char *digits_end = scan::parse_digits(pos, end, id);
+        if (digits_end != pos) out_ids.push_back(id);
+
+        pos = scan::find_byte(digits_end, end, '\n');
+        if (pos != end) ++pos;
+    }
+
+    std::sort(out_ids.begin(), out_ids.end());
+    out_ids.erase(std::unique(out_ids.begin(), out_ids.end()), out_ids.end());
+} // !void excl_index::parse(...)
+
+// Write ids to sidecar, return false if it fails
+bool excl_index::write(const std::string &idx_filename,
+                       const std::vector<std::uint64_t> &ids,
+                       std::uint64_t list_size, std::int64_t list_time)
+{
+    header head;
+    memcpy(head.magic, idx_magic, sizeof(idx_magic));
+    head.list_size = list_size;
+    head.list_time = list_time;
+    head.count = ids.size();
+
+    // Whole sidecar or nothing
+    const std::string tmp_filename = idx_filename + ".tmp";
+    {
+        std::ofstream tmp(tmp_filename, std::ios::binary | std::ios::trunc);
+        tmp.write(reinterpret_cast<const char*>(&head), sizeof(head));
+        if (ids.size())
+        {
+            tmp.write(reinterpret_cast<const char*>(ids.data()),
+                      ids.size()*sizeof(ids[0]));
+        }
+        tmp.flush();
+        if (!tmp) return false;
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmp_filename, idx_filename, ec);
+    return !ec;
+} // !bool excl_index::write(...)
+
+// Map sidecar, return false if it is broken
+bool excl_index::map(const std::string &idx_filename)
+{
+    using namespace boost::interprocess;
+    try
+    {
+        file_mapping new_file(idx_filename.c_str(), read_only);
+        mapped_region new_region(new_file, read_only);
+
+        const size_t size = new_region.get_size();
+        if (size < sizeof(header)) return false;
+        const header *head = static_cast<const header*>(
+                    new_region.get_address());
+        if ((size - sizeof(header)) / sizeof(std::uint64_t) < head->count)
+        {
+            return false;
+        }
+
+        ids = reinterpret_cast<const std::uint64_t*>(head+1);
+        count = static_cast<size_t>(head->count);
+        file.swap(new_file);
+        region.swap(new_region);
+    }
+    catch (interprocess_exception &)
+    {
+        return false;
+    }
+    return true;
+} // !bool excl_index::map(...)
+
+// !excl_index Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// excl_snapshot Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Is id excluded?
+bool excl_snapshot::contains(unsigned long long id) const
+{
+    if (added.count(id)) return true;
+    for (auto &i : lists)
+    {
+        if (i->contains(id)) return true;
+    }
+    return false;
+} // !bool excl_snapshot::contains(...)
+
+// !excl_snapshot Public functions
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,103 @@
+#ifndef EXCL_INDEX_H
+#define EXCL_INDEX_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <cstdint>
+// Ids, if sidecar can't be written or mapped
+#include <vector>
+// Snapshot shares indexes with next ones
+#include <memory>
+// Ids excluded after lists are loaded
+#include <unordered_set>
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Sidecar file is mapped to memory
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#endif // Q_MOC_RUN
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Sorted book ids of one exclude list
+// Ids are kept in binary sidecar "list.txt.idx" next to text list,
+// which is mapped to memory, so nothing is parsed or allocated at startup.
+// Sidecar is rebuilt from text list only when size or modification time
+// of the list differs from ones written in sidecar.
+class excl_index
+{
+public:
+    excl_index();
+
+    // Map sidecar of text list, rebuild it if text list is changed
+    // Missing list is empty
+    void open(const std::string &list_filename);
+
+    // Unmap sidecar
+    void close();
+
+    // Is id in list?
+    bool contains(unsigned long long id) const;
+
+    // Number of ids
+    size_t size() const { return count; }
+
+private:
+    // Sidecar header, ids follow it
+    struct header
+    {
+        char magic[8];
+        std::uint64_t list_size;
+        std::int64_t list_time;
+        std::uint64_t count;
+    };
+
+private:
+    // Is sidecar made from list with this size and time?
+    bool is_fresh(const std::string &idx_filename,
+                  std::uint64_t list_size, std::int64_t list_time) const;
+
+    // Parse text list to sorted unique ids
+    static void parse(const std::string &list_filename,
+                      std::vector<std::uint64_t> &out_ids);
+
+    // Write ids to sidecar, return false if it fails
+    static bool write(const std::string &idx_filename,
+                      const std::vector<std::uint64_t> &ids,
+                      std::uint64_t list_size, std::int64_t list_time);
+
+    // Map sidecar, return false if it is broken
+    bool map(const std::string &idx_filename);
+
+private:
+    boost::interprocess::file_mapping file;
+    boost::interprocess::mapped_region region;
+
+    // Ids when sidecar isn't used
+    std::vector<std::uint64_t> parsed;
+
+    // Sorted ids inside region or parsed
+    const std::uint64_t *ids;
+    size_t count;
+}; // !class excl_index
+
+// Excluded ids at some moment: indexes of lists and ids added since then
+// Snapshot is never changed after it is published, so it is read
+// without locks. Adding ids makes a new snapshot, which shares
+// indexes with old one.
+struct excl_snapshot
+{
+    std::vector<std::shared_ptr<const excl_index>> lists;
+    std::unordered_set<unsigned long long> added;
+
+    // Is id excluded?
+    bool contains(unsigned long long id) const;
+}; // !struct excl_snapshot
+
+#endif // EXCL_INDEX_H
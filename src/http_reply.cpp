@@ -0,0 +1,275 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "http_reply.h"
+
+// Case insensitive compare of header names and values
+#include <boost/algorithm/string.hpp>
+
+// strtoull for chunk size and Content-Length
+#include <cstdlib>
+// Find end of line
+#include <algorithm>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Head helpers
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Space around header's value
+    bool is_space(char c)
+    {
+        return c==' ' || c=='\t';
+    }
+} // !namespace
+
+// !Head helpers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// http_reply Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+http_reply::http_reply(body_handler on_body):
+    on_body(std::move(on_body))
+{
+    reset();
+} // !http_reply::http_reply(...)
+
+// Forget everything and wait for new reply
+void http_reply::reset()
+{
+    state = st_head;
+    head_str.clear();
+    line_str.clear();
+    headers.clear();
+    status_code = 0;
+    keep_conn = false;
+    remain = 0;
+    body_len = 0;
+    encoded = false;
+    decoder.reset();
+} // !void http_reply::reset()
+
+// Parse next piece of bytes from socket
+// and return number of used bytes.
+size_t http_reply::consume(const char *data, size_t size)
+{
+    const char * const beg = data;
+    const char * const end = data+size;
+
+    while (data!=end && state!=st_done)
+    {
+        switch (state)
+        {
+        case st_head:
+        {
+            // "\r\n\r\n" may be split between two pieces
+            size_t old_size = head_str.size();
+            size_t search = old_size < 3 ? 0 : old_size-3;
+            head_str.append(data, end);
+            auto head_end = head_str.find("\r\n\r\n", search);
+            if (head_end == head_str.npos)
+            {
+                if (head_str.size() >= max_head)
+                    throw std::runtime_error("HTTP: Too big head of reply");
+                data = end;
+                break;
+            }
+            // Return body's bytes back to data
+            head_end+=4;
+            data += head_end - old_size;
+            head_str.resize(head_end);
+            parse_head();
+            break;
+        }
+        case st_length:
+        case st_chunk_data:
+        {
+            size_t size = end-data;
+            if (remain < size) size = static_cast<size_t>(remain);
+            add_body(data, size);
+            data+=size;
+            remain-=size;
+            if (!remain) state = state == st_length ? st_done : st_chunk_end;
+            break;
+        }
+        case st_chunk_size:
+            if (add_line(data, end))
+            {
+                // Size is hex, extensions after ';' are ignored
+                remain = strtoull(line_str.c_str(), nullptr, 16);
+                line_str.clear();
+                state = remain ? st_chunk_data : st_trailer;
+            }
+            break;
+        case st_chunk_end:
+            if (add_line(data, end))
+            {
+                line_str.clear();
+                state = st_chunk_size;
+            }
+            break;
+        case st_trailer:
+            if (add_line(data, end))
+            {
+                // Empty line - end of reply
+                if (line_str.size()<=1) state = st_done;
+                line_str.clear();
+            }
+            break;
+        case st_until_close:
+            add_body(data, end-data);
+            data = end;
+            break;
+        case st_done:
+            break;
+        }
+    } // !while (...)
+
+    if (state == st_done) check_body();
+    if (on_raw && data != beg) on_raw(beg, data-beg);
+    return data-beg;
+} // !size_t http_reply::consume(...)
+
+// Connection is closed by server
+void http_reply::finish()
+{
+    if (state == st_until_close) state = st_done;
+    else if (state != st_done)
+        throw std::runtime_error("HTTP: Connection closed before end of reply");
+    keep_conn = false;
+    check_body();
+} // !void http_reply::finish()
+
+// Value of header (name in any case) or empty string
+boost::string_ref http_reply::header(boost::string_ref name) const
+{
+    for (const header_pos &i : headers)
+    {
+        if (boost::iequals(head_part(i.name_beg, i.name_size), name))
+            return head_part(i.value_beg, i.value_size);
+    }
+    return boost::string_ref();
+} // !boost::string_ref http_reply::header(...) const
+
+// !http_reply Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// http_reply Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Parse status line and headers in head_str
+void http_reply::parse_head()
+{
+    // Status line: HTTP/1.1 200 OK
+    auto line_end = head_str.find("\r\n");
+    auto code_pos = head_str.find(' ');
+    if (head_str.compare(0, 5, "HTTP/") || code_pos > line_end)
+        throw std::runtime_error("HTTP: Bad status line");
+    status_code = strtoul(head_str.c_str()+code_pos, nullptr, 10);
+    // HTTP/1.0 closes connection by default
+    keep_conn = head_str.compare(0, 8, "HTTP/1.0")!=0;
+
+    // Headers: Name: value
+    for (auto beg = line_end+2; beg < head_str.size(); beg = line_end+2)
+    {
+        line_end = head_str.find("\r\n", beg);
+        auto colon = head_str.find(':', beg);
+        if (colon >= line_end) continue;
+
+        // Value without spaces around
+        size_t value_beg = colon+1;
+        size_t value_end = line_end;
+        while (value_beg < value_end && is_space(head_str[value_beg]))
+            ++value_beg;
+        while (value_end > value_beg && is_space(head_str[value_end-1]))
+            --value_end;
+
+        const header_pos pos = { beg, colon-beg,
+                                 value_beg, value_end-value_beg };
+        headers.push_back(pos);
+    }
+
+    const boost::string_ref connection = header("connection");
+    if (boost::iequals(connection, "close")) keep_conn = false;
+    else if (boost::iequals(connection, "keep-alive")) keep_conn = true;
+
+    // Interim reply, real one is next
+    if (status_code/100 == 1)
+    {
+        head_str.clear();
+        headers.clear();
+        status_code = 0;
+        return;
+    }
+
+    // Replies without body
+    if (status_code == 204 || status_code == 304)
+    {
+        state = st_done;
+    }
+    else if (boost::icontains(header("transfer-encoding"), "chunked"))
+    {
+        state = st_chunk_size;
+    }
+    else if (header("content-length").size())
+    {
+        // Value is followed by "\r\n" in head_str, so it ends there
+        remain = strtoull(header("content-length").data(), nullptr, 10);
+        state = remain ? st_length : st_done;
+    }
+    else // Body ends with connection
+    {
+        keep_conn = false;
+        state = st_until_close;
+    }
+
+    // Compressed body is decoded before body_handler
+    encoded = state != st_done && decoder.start(header("content-encoding"));
+} // !void http_reply::parse_head()
+
+// Pass body piece to body_handler
+void http_reply::add_body(const char *data, size_t size)
+{
+    if (!size) return;
+    body_len+=size;
+    if (!on_body) return;
+    if (encoded) decoder.feed(data, size, on_body);
+    else on_body(data, size);
+} // !void http_reply::add_body(...)
+
+// Collect line (chunk size or trailer) in line_str
+// return true if line is complete
+bool http_reply::add_line(const char *&data, const char *end)
+{
+    const char *line_end = std::find(data, end, '\n');
+    if (line_end == end)
+    {
+        line_str.append(data, end);
+        data = end;
+        if (line_str.size() >= max_head)
+            throw std::runtime_error("HTTP: Too long line in chunked body");
+        return false;
+    }
+    line_str.append(data, line_end);
+    data = line_end+1;
+    return true;
+} // !bool http_reply::add_line(...)
+
+// Throw if compressed body ended before its stream
+void http_reply::check_body() const
+{
+    // Without handler body isn't decoded
+    if (encoded && on_body && !decoder.finished())
+        throw std::runtime_error("HTTP: Compressed body is incomplete");
+} // !void http_reply::check_body() const
+
+// !http_reply Private functions
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,213 @@
+#ifndef HTTP_REPLY_H
+#define HTTP_REPLY_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Body is passed to user as it arrives
+#include <functional>
+// Status line and headers
+#include <string>
+#include <vector>
+#include <utility>
+// Reply is incomplete, too big head, etc.
+#include <stdexcept>
+// Time of request phases
+#include <chrono>
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Network:
+#include <boost/asio.hpp>
+// Values of headers are slices of head, without copy
+#include <boost/utility/string_ref.hpp>
+
+#endif // Q_MOC_RUN
+
+// Stop reading if task is cancelled
+#include "cancel_token.h"
+// Body with Content-Encoding: gzip or deflate
+#include "body_decoder.h"
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Incremental HTTP/1.1 reply reader
+// Feed it with bytes as they come from socket, it parses status line
+// and headers, and then passes body to body_handler.
+// The end of reply is found by Content-Length, chunked transfer-encoding
+// or closing of connection - no waiting for silence.
+// Body with gzip or deflate content-encoding is decoded as it arrives.
+class http_reply
+{
+public:
+    // Receives body without transfer and content encoding, piece by piece
+    typedef std::function<void (const char *data, size_t size)> body_handler;
+
+public:
+    explicit http_reply(body_handler on_body = body_handler());
+
+    // Forget everything and wait for new reply
+    void reset();
+
+    // Parse next piece of bytes from socket
+    // and return number of used bytes.
+    // It is less than size only if reply is complete.
+    size_t consume(const char *data, size_t size);
+
+    // Connection is closed by server
+    // This is normal end only for reply without length
+    void finish();
+
+    // Reply is fully received
+    bool complete() const { return state == st_done; }
+
+    // Status code from status line, 0 if not received yet
+    unsigned status() const { return status_code; }
+
+    // Status line and headers as is
+    const std::string &head() const { return head_str; }
+
+    // Value of header (name in any case) or empty string
+    // It is a slice of head, valid until reset or the next reply
+    boost::string_ref header(boost::string_ref name) const;
+
+    // Can connection be used for the next request
+    bool keep_alive() const { return keep_conn; }
+
+    // Bytes of body received (without chunk's size, etc.), before decoding
+    size_t body_size() const { return body_len; }
+
+    // Receives every used byte from socket as is, before parsing
+    // This is for recording of replies, empty handler stops it
+    void set_raw_handler(body_handler on_raw)
+    { this->on_raw = std::move(on_raw); }
+
+private:
+    // Parse status line and headers in head_str
+    void parse_head();
+
+    // Pass body piece to body_handler
+    void add_body(const char *data, size_t size);
+
+    // Collect line (chunk size or trailer) in line_str
+    // return true if line is complete
+    bool add_line(const char *&data, const char *end);
+
+    // Throw if compressed body ended before its stream
+    void check_body() const;
+
+    // Slice of head_str
+    boost::string_ref head_part(size_t beg, size_t size) const
+    { return boost::string_ref(head_str.data()+beg, size); }
+
+private:
+    // What is parsing now
+    enum parse_state
+    {
+        st_head,        // Status line and headers
+        st_length,      // Body with Content-Length
+        st_chunk_size,  // Line with size of next chunk
+        st_chunk_data,  // Chunk's data
+        st_chunk_end,   // CRLF after chunk's data
+        st_trailer,     // Headers after last chunk
+        st_until_close, // Body without length, ends with connection
+        st_done         // Reply is complete
+    };
+
+    // Head this size or bigger is not a HTTP reply
+    static const size_t max_head = 64*1024;
+
+    // Header in head_str: name and trimmed value
+    // Headers are kept as offsets, so reused reply parses head
+    // without allocation
+    struct header_pos
+    {
+        size_t name_beg;
+        size_t name_size;
+        size_t value_beg;
+        size_t value_size;
+    };
+
+private:
+    body_handler on_body;
+    body_handler on_raw;
+
+    parse_state state;
+
+    // Status line and headers as is
+    std::string head_str;
+    // Chunk size line or trailer line
+    std::string line_str;
+    // Headers in order of head
+    std::vector<header_pos> headers;
+
+    unsigned status_code;
+    bool keep_conn;
+
+    // Body bytes remain in current chunk or in body with Content-Length
+    unsigned long long remain;
+    // Body bytes received
+    size_t body_len;
+
+    // Body is compressed and goes through decoder
+    bool encoded;
+    body_decoder decoder;
+}; // !class http_reply
+
+// Time spent in phases of one request, zero if phase was skipped
+// Phases of retried request are added up
+struct request_timing
+{
+    typedef std::chrono::steady_clock clock;
+
+    request_timing(): dns(), connect(), first_byte(), body() {}
+
+    // Lookup of host, and TCP handshake if connection wasn't reused
+    clock::duration dns;
+    clock::duration connect;
+    // From request sent to the first byte of reply
+    clock::duration first_byte;
+    // From the first byte to the end of reply
+    clock::duration body;
+}; // !struct request_timing
+
+// Read from socket exactly one reply
+// Throw if connection is broken before reply is complete
+// or task_cancelled if token is cancelled
+template <typename SyncReadStream>
+void read_http_reply(SyncReadStream &socket, http_reply &reply,
+                     const cancel_token *token = nullptr,
+                     request_timing *timing = nullptr)
+{
+    typedef request_timing::clock clock;
+    const clock::time_point start = clock::now();
+    clock::time_point first = start;
+    bool received = false;
+
+    char chunk[16*1024];
+    boost::system::error_code ec;
+    while (!reply.complete())
+    {
+        if (token) token->check();
+        size_t size = socket.read_some(boost::asio::buffer(chunk), ec);
+        if (!received && timing)
+        {
+            received = true;
+            first = clock::now();
+            timing->first_byte += first - start;
+        }
+        if (ec == boost::asio::error::eof)
+        {
+            reply.finish();
+            break;
+        }
+        else if (ec) throw boost::system::system_error(ec);
+
+        reply.consume(chunk, size);
+    }
+    if (received) timing->body += clock::now() - first;
+} // !void read_http_reply(...)
+
+#endif // HTTP_REPLY_H
@@ -9,8 +9,15 @@
 #include "log_pass.h"
 #include "ui_log_pass.h"
 
-// Replace algorithm
-#include <boost/algorithm/string.hpp>
+// Remove excluded books from prefetch queue
+#include <algorithm>
+#include <unordered_set>
+
+// Status bar updates
+#include <QTimer>
+// Reload of changed settings and lists
+#include <QFileSystemWatcher>
+#include <QFile>
 
 // !Headers
 ///////////////////////////////////////////////////////////////////////////////
@@ -19,575 +26,183 @@
 // IUNB Private functions
 ///////////////////////////////////////////////////////////////////////////////
 
-// Wait for threads to finish
-// This makes possible to change settings, cookie, etc without reload
-void IUNB::wait_for_tasks()
+// Load settings and exclude lists of user,
+// and make actions for exclude lists
+void IUNB::load_settings(const std::string &username)
 {
+    core.load_settings(username);
 
-    emit status_prepared(QString("General: Waiting for ")
-                         .append(QString::number(tasks_list.size()))
-                         .append(" tasks to finish"));
-    while (tasks_list.size())
-    {
-        tasks_list.remove_if([this](std::future<void> &ref)
-        {
-            if (ref.wait_for(std::chrono::seconds(0))!=std::future_status::timeout)
-            {
-
-                emit status_prepared(QString("General: Tasks remain: ")
-                                     .append(QString::number(tasks_list.size())));
-
-                // Display exception what() in status bar, if any
-                try
-                {
-                    ref.get();
-                }
-                catch (std::exception &ref)
-                {
-                    emit status_prepared(QString("Fail: ").append(ref.what()));
-                }
-                catch (...)
-                {
-                    emit status_prepared("Fail: Unknown");
-                }
-                return true;
-            }
-            return false;
-        });
-    }
+    // Files of previous user aren't watched
+    reload_timer->stop();
+    reload_pref = reload_lists = false;
+    if (!watcher->files().isEmpty()) watcher->removePaths(watcher->files());
+    watch_files();
 
-    emit status_prepared("General: Tasks finished");
-} // !void IUNB::wait_for_tasks()
+    make_list_actions();
+} // !void IUNB::load_settings(...)
 
-// Load settings or create default
-void IUNB::load_settings()
+// Make action for every exclude list
+void IUNB::make_list_actions()
 {
-
-    std::string xml_filename("./rsrc/");
-    xml_filename += username + ".pref.xml";
-
-    wait_for_tasks();
-
-    emit status_prepared("XML: Loading");
-
-    try
-    {
-        boost::property_tree::read_xml(xml_filename, xml_pref);
-    }
-    catch (boost::property_tree::xml_parser_error &)
-    {
-
-        emit status_prepared("XML: File not found, create default ");
-
-        std::ofstream(xml_filename)
-                << std::ifstream("./rsrc/.pref.xml").rdbuf();
-
-        emit status_prepared("XML: Default file created ");
-
-        boost::property_tree::read_xml(xml_filename, xml_pref);
-    }
-
-    emit status_prepared("XML: Loaded");
-
-    load_lists();
-} // !void IUNB::load_settings()
-
-void IUNB::load_lists()
-{
-
-    emit status_prepared("Exclude lists: Loading");
-
-    // Load lists file
-    std::string all_lists_filename("./rsrc/lists/");
-    all_lists_filename+=username+".lists.txt";
-    std::ifstream all_lists_file(all_lists_filename);
-
-    // Create default if this doesn't exist
-    if (!all_lists_file.is_open())
-    {
-        emit status_prepared("Exclude lists: File not found, creating default");
-
-        all_lists_file.close();
-        all_lists_file.clear();
-
-        std::ofstream(all_lists_filename)
-                << std::ifstream("./rsrc/lists/.lists.txt").rdbuf();
-
-        all_lists_file.open(all_lists_filename);
-
-        emit status_prepared("Exclude lists: Default file created");
-    }
-
     // Refresh QAction in QActionGroup excl_lists
     if (excl_lists) delete excl_lists;
     excl_lists = new QActionGroup(this);
     connect(excl_lists, SIGNAL(triggered(QAction*)),
             this, SLOT(add_exclude_book(QAction*)));
-    // and clear old id sets
-    excl_id.clear();
-    new_excl_id.clear();
-
-    // Related to exclude list file QAction
-    QAction * pQA;
-    // and shared_ptr to this file
-    pofstr shp_ofstr;
-    // Filename of this file
-    std::string list_filename;
-    // Name of this action
-    std::string list_name;
-
-    // Used to load id from exclude file into excl_id set
-    std::ifstream list_file;
-    unsigned long long book_id;
-
-    // Add action to every file in ...lists.txt
-    while (all_lists_file)
-    {
-        // Get list's filename
-        getline(all_lists_file, list_filename, ';');
-        boost::replace_first(list_filename, "$username", username);
-        // Get list's name - action's text
-        getline(all_lists_file, list_name);
-        // if (end)
-        if (!all_lists_file) break;
-
-        // Load book id from exclude lists
-        list_file.open(list_filename);
-        while (list_file)
-        {
-            list_file >> book_id;
-            excl_id.emplace(book_id);
-            list_file.ignore(INTMAX_MAX, '\n');
-        }
-        list_file.close();
-        list_file.clear();
 
+    // Add action to every exclude list
+    for (const engine::excl_list &list : *core.lists())
+    {
         // Create action and associate with related list's file
-        pQA = new QAction(list_name.c_str(), excl_lists);
-        shp_ofstr.reset(new std::ofstream(list_filename, std::ios::app));
-        pQA->setData(QVariant::fromValue(shp_ofstr));
+        QAction *pQA = new QAction(list.name.c_str(), excl_lists);
+        pQA->setData(QString::fromStdString(list.filename));
         // and display it
         ui->TB_main->addAction(pQA);
     }
+} // !void IUNB::make_list_actions()
 
-    emit status_prepared("Exclude lists: Loaded");
-} // !void IUNB::load_lists()
-
-//Unload new exclude book's id
-void IUNB::unload_new_excl_id()
-{
-    wait_for_tasks();
-
-    for (auto i : new_excl_id) excl_id.emplace(i);
-
-    new_excl_id.clear();
-} // !void IUNB::unload_new_excl_id()
-
-// Connect, send auth info, save parsed reply to cookie to be auth.
-void IUNB::authorize(const std::string &login, const std::string &password)
+// Watch settings and lists files of user, if they aren't watched
+void IUNB::watch_files()
 {
-    emit status_prepared("Authorize: Starting");
-
-    // Get from XML POST request
-    // and replace $password and $login with user input if any
-    std::string post_req = xml_pref.get<std::string>("pref.auth.POST");
-    boost::replace_first(post_req, "$login", login);
-    boost::replace_first(post_req, "$password", password);
-
-    // Get from XML GET request
-    // and replace $Content-Length with size of post request
-    std::string get_req = xml_pref.get<std::string>("pref.auth.GET");
-    boost::replace_first(get_req, "$Content-Length",
-                         std::to_string(post_req.size()));
-
-    // Add POST to GET
-    get_req+=post_req;
-
-    emit status_prepared("Authorize: Connecting");
-
-    // Standart TCP socket
-    boost::asio::ip::tcp::socket socket(io_service);
-    // Query = imhonet.ru:80 if default.
-    boost::asio::ip::tcp::resolver::query query(
-                xml_pref.get<std::string>("pref.site.addr"),
-                xml_pref.get<std::string>("pref.site.port"));
-    // Connect to machine-like endpoint range
-    boost::asio::ip::tcp::resolver resolver(io_service);
-    boost::asio::connect(socket,resolver.resolve(query));
-    // Send GET request with POST data from above
-    boost::asio::write(socket, boost::asio::buffer(get_req));
-    // Size of this string will be equal to bytes in socket
-    std::string reply(wait_for_reply(socket), '\0');
-    // Get reply from server with user id, user hash and phpsid
-    boost::asio::read(socket, boost::asio::buffer(&reply[0], reply.size()));
-
-    emit status_prepared("Authorize: Parsing reply");
-
-    // Make cookie
-    std::string new_cookie("Cookie:");
-    // Add to cookie user_id from reply if any
-    add_cookie(new_cookie, reply,
-               xml_pref.get<std::string>("pref.auth.user_id"));
-    // Add to cookie user_hash from reply if any
-    add_cookie(new_cookie, reply,
-               xml_pref.get<std::string>("pref.auth.user_hash"));
-    // Add to cookie PHPSID from reply if any
-    add_cookie(new_cookie, reply,
-               xml_pref.get<std::string>("pref.auth.PHPSID"));
-
-    emit status_prepared("Authorize: Parsed");
-
-    emit cookie_updated(QByteArray(new_cookie.c_str(), new_cookie.size()));
-} // !void IUNB::authorize(...)
+    // Editors save by writing new file and renaming it,
+    // then old file isn't watched anymore
+    const QString files[] = {
+        QString::fromStdString(core.settings_filename()),
+        QString::fromStdString(core.lists_filename())
+    };
+    for (const QString &file : files)
+    {
+        if (!watcher->files().contains(file) && QFile::exists(file))
+            watcher->addPath(file);
+    }
+} // !void IUNB::watch_files()
 
 // Run authorize (...) asynchronously
 void IUNB::async_authorize(const std::string &login,
                            const std::string &password)
 {
-    tasks_list.emplace_back(std::async(std::launch::async,
-                                       &IUNB::authorize, this, login, password));
+    cancel_token::ptoken token = core.new_task_token();
+    core.pool().post([this, login, password, token]()
+    {
+        const std::string new_cookie = core.authorize(login, password, token);
+        emit cookie_updated(QByteArray(new_cookie.c_str(), new_cookie.size()));
+    });
 } // !void IUNB::async_authorize(...)
 
-// Waiting either 1 second or until socket buffer is full
-// and return size of available bytes
-size_t IUNB::wait_for_reply(const boost::asio::ip::tcp::socket &socket)
+// Run get_unread() asynchronously
+void IUNB::async_get_unread()
 {
-    boost::asio::ip::tcp::socket::receive_buffer_size buf_size;
-    socket.get_option(buf_size);
-    size_t size = socket.available();
-    for (size_t wait_count(0), prev_size(0); wait_count<10; prev_size=size)
+    cancel_token::ptoken token = core.new_task_token();
+    search_token = token;
+    const unsigned search = this->search;
+    core.pool().post([this, token, search]()
     {
-        if (prev_size==size)
+        core.get_unread(token, [this, search](unsigned long long id,
+                                              const char *title, size_t size)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            ++wait_count;
-        } else wait_count=0;
-        size = socket.available();
-        if (size==buf_size.value()) break;
-    }
-    return size;
-} // !size_t IUNB::wait_for_reply(...)
+            add_unread(id, title, size, search);
+        });
+    });
+} // !void IUNB::async_get_unread()
 
-// Add to out_str cookie sequence from src,
-// that begins with beg_req and end with ';'
-void IUNB::add_cookie(std::string &out_str, const std::string &src,
-                      const std::string &beg_req)
+// Pass unread book to GUI thread, called by worker
+void IUNB::add_unread(unsigned long long id, const char *title, size_t size,
+                      unsigned search)
 {
-    auto beg_pos = src.find(beg_req);
-    if (beg_pos!=src.npos)
+    found_book book;
+    book.book.id = id;
+    book.book.title = QString::fromUtf8(title, size);
+    book.search = search;
+    book.sent = metrics::clock::now();
+
+    bool first;
     {
-        auto end_pos = src.find(';', beg_pos);
-        if (end_pos!=src.npos)
-        {
-            out_str+=' ';
-            out_str.append(src, beg_pos, ++end_pos-beg_pos);
-        }
+        std::lock_guard<std::mutex> lock(found_mutex);
+        first = found.empty();
+        found.push_back(std::move(book));
     }
-} // !void IUNB::add_cookie(...)
+    // GUI thread takes all books found before it runs
+    if (first) emit books_found();
+} // !void IUNB::add_unread(...)
 
-// Send GET with cookie
-// Get reply and parse it for unread books
-// Repeat until count(unread books) < num from xml settings
-void IUNB::get_unread()
+// Get book's description asynchronously
+// book_info_done is emitted when it is finished
+void IUNB::async_get_book_info(book_list::book &b, bool prefetch)
 {
-    emit status_prepared("Unread: Starting");
-
-    // GET request without cookie and page_num yet
-    std::string get_req = xml_pref.get<std::string>("pref.unread.GET");
-    // and replace $Cookie with cookie
-    boost::replace_first(get_req, "$Cookie", cookie);
-
-    // Find pos for replacing $pagenumber with 1-...N+1 in for () below
-    // This allow to visit next page
-    size_t len = 0;
-    char c_page_num[50];
-    size_t pos = get_req.find("$pagenumber");
-    if (pos!=get_req.npos)
-        len=strlen("$pagenumber");
-
-    // Start searching from this page
-    size_t page_num = xml_pref.get<size_t>("pref.unread.start_page");
-    // Minimum desired number of unread books
-    size_t num = xml_pref.get<size_t>("pref.unread.num");
-
-    // Standart TCP socket
-    boost::asio::ip::tcp::socket socket(io_service);
-    // Query = imhonet.ru:80 if default.
-    boost::asio::ip::tcp::resolver::query query(
-                xml_pref.get<std::string>("pref.site.addr"),
-                xml_pref.get<std::string>("pref.site.port"));
-    // Connect to machine-like endpoint range
-    boost::asio::ip::tcp::resolver resolver(io_service);
-    boost::asio::connect(socket,resolver.resolve(query));
-
-    // Buffer for receiving from server
-    std::string buf;
-
-    // Used in for(...) below
-    size_t offs(0), prev_offs(0), size(0), beg_search(0);
-
-    // count - unread books. num - desired.
-    for (size_t count(0); count < num; )
+    b.loading = true;
+
+    const unsigned long long id = b.id;
+    cancel_token::ptoken token = core.new_task_token();
+    core.pool().post([this, id, token, prefetch]()
     {
-        // Convert integer page_num to c-style string c_page_num,
-        // and replace $pagenumber with it
-        // pos from above, if any
-        if (pos!=get_req.npos)
+        std::string descr;
+        try
         {
-            _itoa_s(page_num++, c_page_num, 10);
-            get_req.replace(pos, len, c_page_num);
-            len=strlen(c_page_num);
+            core.get_book_info(id, descr, token);
         }
-
-        emit status_prepared(QString("Unread: Page processing ")
-                           .append(c_page_num));
-
-        // Send GET request with cookie data from above
-        boost::asio::write(socket, boost::asio::buffer(get_req));
-
-        // Get Reply and parse it
-        while (size=wait_for_reply(socket))
+        catch (...)
         {
-            // Resize if not enough
-            if (buf.size()-offs < size) buf.resize((buf.size()+size)*2);
-            // Get reply and save to string with offset - offs
-            boost::asio::read(socket,
-                              boost::asio::buffer(&buf[offs], size));
-            offs+=size;
-
-            // 14 == strlen("data-rate=\"\"")
-            parse_for_unread(buf, beg_search, count);
-            beg_search=offs-14;
-
-            // Have I received any?
-            if (offs!=prev_offs) prev_offs=offs;
-            else break;
-        }// !while (...)
-    }// !for (...)
-
-} // !void IUNB::get_unread()
-
-// Run get_unread() asynchronously
-void IUNB::async_get_unread()
-{
-    tasks_list.emplace_back(std::async(std::launch::async,
-                                       &IUNB::get_unread, this));
-} // !void IUNB::async_get_unread()
-
-// Parse string for unread books
-void IUNB::parse_for_unread(const std::string &src,
-                            size_t beg_search,
-                            size_t &out_count)
-{
-
-    auto beg_pos = src.npos;
-    auto end_pos = src.npos;
-
-    QListWidgetItem *item;
-    std::shared_ptr<item_info> it_inf;
-
-    unsigned long long id;
-
-     for (  auto unread_book_pos = src.find("data-rate=\"\"", beg_search);
-            unread_book_pos!=src.npos;
-            unread_book_pos = src.find("data-rate=\"\"", ++unread_book_pos))
-     {
-         // URL with required inf
-         beg_pos = src.rfind("<a href=\"", unread_book_pos);
-         if (beg_pos==src.npos) continue;
-
-         // Get book id
-         while (!isdigit(src[++beg_pos]));
-         id = strtoul(src.c_str()+beg_pos, nullptr, 10);
-
-         // Is this a book from exclude lists?
-         if (excl_id.count(id)) continue;
-
-         // Get book name
-         beg_pos = src.find('>', beg_pos);
-         if ((beg_pos++)==src.npos) continue;
-         while (src[++beg_pos]==' ');
-         end_pos = src.find('<', beg_pos);
-         if (end_pos==src.npos) continue;
-         while (src[--end_pos]==' ');
-
-         // Add item to list widget
-         item = new QListWidgetItem(QString::fromUtf8(src.c_str()+beg_pos,
-                                                      end_pos-beg_pos));
-         it_inf.reset(new item_info(id));
-         item->setData(Qt::UserRole,
-                       QVariant::fromValue(it_inf));
-         emit book_found(item);
-
-         ++out_count;
-     }
-
-} // !void IUNB::parse_for_unread(...)
+            emit book_info_done(id, prefetch);
+            throw;
+        }
 
-// Get book's description
-void IUNB::get_book_info(QListWidgetItem *item)
+        // Display received
+        emit book_info_updated(id, QString::fromUtf8(descr.c_str(),
+                                                     descr.size()),
+                               metrics::clock::now().time_since_epoch().count());
+        emit book_info_done(id, prefetch);
+    });
+} // !void IUNB::async_get_book_info(...)
+
+// Set book's description from disk cache
+// Return true if it must be requested from site
+bool IUNB::load_cached_info(book_list::book &b)
 {
-    // Item_info inside item
-    pit_inf it_inf = item->data(Qt::UserRole).value<pit_inf>();
-
-    // Book id
-    const std::string id = std::to_string(it_inf->id);
-
-    emit status_prepared("Book info: Getting description");
-
-    // GET request
-    std::string get_req = xml_pref.get<std::string>("pref.book_info.GET");
-    // replace $id with id
-    boost::replace_first(get_req, "$id", id);
-
-    // Standart TCP socket
-    boost::asio::ip::tcp::socket socket(io_service);
-    // Query = imhonet.ru:80 if default.
-    boost::asio::ip::tcp::resolver::query query(
-                xml_pref.get<std::string>("pref.site.addr"),
-                xml_pref.get<std::string>("pref.site.port"));
-    // Connect to machine-like endpoint range
-    boost::asio::ip::tcp::resolver resolver(io_service);
-    boost::asio::connect(socket,resolver.resolve(query));
-    // Send GET request
-    boost::asio::write(socket, boost::asio::buffer(get_req));
-
-    // Used in while (...) below
-    size_t offs(0), prev_offs(0), size(0), beg_search(0);
-
-    std::string buf;
     std::string descr;
-    // Get reply and parse it
-    while (size=wait_for_reply(socket))
+    bool request = core.load_cached_info(b.id, descr);
+    if (descr.size())
     {
-        // Resize if not enough
-        if (buf.size()-offs < size) buf.resize((buf.size()+size)*2);
-        // Get reply and save to string with offset - offs
-        boost::asio::read(socket,
-                          boost::asio::buffer(&buf[offs], size));
-        offs+=size;
-
-        // Return true if description found
-        if (parse_for_descr(buf, descr,  beg_search))
-        {
-            break;
-        }
-        // 34 = strlen("data-content=\"Похожие книги\">")
-        beg_search=offs-34;
+        b.descr = QString::fromUtf8(descr.c_str(), descr.size());
+    }
+    return request;
+} // !bool IUNB::load_cached_info(...)
 
-        // Have I received any?
-        if (offs!=prev_offs) prev_offs=offs;
-        else break;
-    }// !while (...)
+// Queue book in row and its neighbours for prefetch
+void IUNB::prefetch_near(int row, size_t num)
+{
+    const int count = books->rowCount();
 
-    if (descr.size())
+    // The nearest first, below before above
+    for (int i = 1; i <= static_cast<int>(num); ++i)
     {
-        descr+="<a href=\"http://books.imhonet.ru/element/";
-        descr+=id;
-        descr+="\">Посмотреть книгу на сайте</a>";
+        if (row+i < count) prefetch_queue.push_back(books->at(row+i).id);
+        if (row-i >= 0) prefetch_queue.push_back(books->at(row-i).id);
     }
-    // Set item_info string
-    it_inf->str = QString::fromUtf8(descr.c_str(), descr.size());
-
-    // Display received
-    emit book_info_updated(item);
-} // !void IUNB::get_book_info()
+} // !void IUNB::prefetch_near(...)
 
-// Run get_book_info() asynchronously
-void IUNB::async_get_book_info(QListWidgetItem *item)
+// Request queued descriptions while budget allows
+void IUNB::run_prefetch()
 {
-    tasks_list.emplace_back(std::async(std::launch::async,
-                                       &IUNB::get_book_info, this, item));
-} // !void IUNB::async_get_book_info()
+    const size_t budget = core.pref()->book_info.prefetch_parallel;
 
-// Get book's description from reply
-bool IUNB::parse_for_descr(const std::string &src, std::string &out_src,
-                           size_t beg_serch)
-{
-    // All the necessary information is found
-    auto end_pos = src
-            .find("data-content=\"Похожие книги\">",
-                   beg_serch);
-    if (end_pos == src.npos) return false;
-    auto beg_pos = src.rfind("<span class=\"fn\">", end_pos);
-    if (beg_pos == src.npos) return false;
-
-    emit status_prepared("Book info: Parsing description");
-
-    // Book name
-    out_src = "<center><h1>";
-    add_by_tag(src, out_src, "<span class=\"fn\">", beg_pos, 0)
-    += "</h1></center>";
-
-    // Average rating
-    out_src+="Оценка: ";
-    add_by_tag(src, out_src, "<span class=\"average\">", beg_pos, 0)
-    += "<br>";
-
-    // Votes
-    out_src+="Проголосовавших: ";
-    add_by_tag(src, out_src, "<span class=\"votes\">", beg_pos, 0)
-    += "<br>";
-
-    // Description
-    add_by_tag(src, out_src, "<p class=\"summary\">", beg_pos, 1)
-    += "<br>";
-
-    return true;
-} // !bool IUNB::parse_for_descr(...)
-
-// Append to string html node with tag if "with" == true
-std::string &IUNB::add_by_tag(const std::string &src, std::string &out_str,
-                              std::string o_tag, size_t &in_beg_pos,
-                              bool with)
-{
-    // Find string with full tag
-    auto beg_pos = src.find(o_tag, in_beg_pos);
-    if (beg_pos == src.npos) return out_str;
-
-    // Make short tag from full
-    o_tag = std::string(o_tag, 0, o_tag.find_first_of(" >"));
-    // and close tag
-    std::string c_tag(o_tag);
-    // <tag -> </tag>
-    c_tag.insert(1,1, '/')+='>';
-
-    // Find correct position of close tag
-    auto end_pos = beg_pos;
-    for (size_t count(1); count; )
+    while (prefetching < budget && prefetch_queue.size())
     {
-        end_pos = src.find('<', ++end_pos);
-        if (end_pos == src.npos) return out_str;
+        const int row = books->row_of(prefetch_queue.front());
+        prefetch_queue.pop_front();
+        // Excluded already
+        if (row < 0) continue;
 
-        // It is close tag
-        if (!memcmp(src.data()+end_pos,
-                    c_tag.data(), c_tag.size()))
-        {
-            --count;
-        }
-        // It is open tag
-        else if (!memcmp(src.data()+end_pos,
-                         o_tag.data(), o_tag.size()))
+        // Already loaded or being loaded
+        book_list::book &b = books->at(row);
+        if (!b.descr.isNull() || b.loading) continue;
+
+        if (load_cached_info(b))
         {
-            ++count;
+            ++prefetching;
+            async_get_book_info(b, true);
         }
-    } // !for (...)
-
-    // With tag
-    if (with)
-    {
-        end_pos = src.find('>', end_pos);
-        out_str.append(src, beg_pos, ++end_pos - beg_pos);
-    }
-    else // without
-    {
-        beg_pos = src.find('>', beg_pos);
-        out_str.append(src, ++beg_pos, end_pos - beg_pos);
     }
-
-    in_beg_pos = end_pos;
-    return out_str;
-} // !std::string &IUNB::add_by_tag(...)
+} // !void IUNB::run_prefetch()
 
 // !IUNB Private functions
 ///////////////////////////////////////////////////////////////////////////////
@@ -600,16 +215,44 @@ std::string &IUNB::add_by_tag(const std::string &src, std::string &out_str,
 IUNB::IUNB(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::IUNB),
-    excl_lists(nullptr)
+    excl_lists(nullptr),
+    watcher(new QFileSystemWatcher(this)),
+    reload_timer(new QTimer(this)),
+    reload_pref(false),
+    reload_lists(false),
+    books(new book_list(this)),
+    search(0),
+    prefetching(0)
 {
-
     ui->setupUi(this);
+    ui->W_unread_list->setModel(books);
+
+    // Changed files are reloaded in background, tasks aren't stopped
+    connect(watcher, SIGNAL(fileChanged(QString)),
+            this, SLOT(file_changed(QString)));
+    reload_timer->setSingleShot(true);
+    reload_timer->setInterval(300);
+    connect(reload_timer, SIGNAL(timeout()), this, SLOT(reload_files()));
+
+    // Status bar isn't updated for every log record
+    QTimer *status_timer = new QTimer(this);
+    connect(status_timer, SIGNAL(timeout()), this, SLOT(show_status()));
+    status_timer->start(250);
+
+    // and stats are exported not so often
+    QTimer *metrics_timer = new QTimer(this);
+    connect(metrics_timer, SIGNAL(timeout()), this, SLOT(export_metrics()));
+    metrics_timer->start(10000);
 } // !IUNB::IUNB(...)
 
 //
 IUNB::~IUNB()
 {
-    wait_for_tasks();
+    // Tasks use ui
+    core.cancel_tasks();
+
+    export_metrics();
+
     delete ui;
 } // !IUNB::~IUNB()
 
@@ -625,10 +268,10 @@ void IUNB::on_A_Authorize_triggered()
 {
     // Get password and login from user
     log_pass lp(this); lp.exec();
-    username             = lp.ui->Login->text().toStdString();
+    std::string username = lp.ui->Login->text().toStdString();
     std::string password = lp.ui->Password->text().toStdString();
 
-    load_settings();
+    load_settings(username);
 
     async_authorize(username, password);
 }// !void IUNB::on_A_Authorize_triggered()
@@ -637,96 +280,227 @@ void IUNB::on_A_Authorize_triggered()
 void IUNB::on_A_Get_Unread_triggered()
 {
     // Load settings if not yet
-    if (xml_pref.empty()) load_settings();
-    // Unload new exclude book's id, if any
-    if (new_excl_id.size()) unload_new_excl_id();
+    if (!core.is_loaded()) load_settings(std::string());
+    // Stop previous search, its books are dropped when they arrive
+    // Authorize and book's info tasks go on
+    if (search_token) search_token->cancel();
+    ++search;
 
-    ui->W_unread_list->clear();
+    prefetch_queue.clear();
+    books->clear();
 
     async_get_unread();
 } // !void IUNB::on_A_Get_Unread_triggered()
 
-// Load item's book description
-void IUNB::on_W_unread_list_itemClicked(QListWidgetItem *item)
+// Load clicked book's description
+void IUNB::on_W_unread_list_clicked(const QModelIndex &index)
 {
-    // Item info inside item
-    pit_inf it_inf = item->data(Qt::UserRole).value<pit_inf>();
-    // Load book info
-    if (it_inf->str.isNull())
+    if (!index.isValid()) return;
+    book_list::book &b = books->at(index.row());
+    // Clicked book goes before all prefetched
+    prefetch_queue.clear();
+
+    // Load book info from cache, refresh it if stale
+    if (b.loading)
+    {
+        ui->TB_book_info->setText("<center><h1>Processing...</h1></center>");
+    }
+    else if (b.descr.isNull())
     {
-        it_inf->str = "<center><h1>Processing...</h1></center>";
-        ui->TB_book_info->setText(it_inf->str);
-        async_get_book_info(item);
+        bool request = load_cached_info(b);
+        if (b.descr.isNull())
+        {
+            ui->TB_book_info->setText("<center><h1>Processing...</h1></center>");
+        }
+        else
+        {
+            ui->TB_book_info->setText(b.descr);
+        }
+        if (request) async_get_book_info(b, false);
     }
     else // or display if exist already
     {
-        ui->TB_book_info->setText(it_inf->str);
+        ui->TB_book_info->setText(b.descr);
     }
-} // !void IUNB::on_W_unread_list_itemClicked(...)
 
-// Show message in status bar and write to log
-void IUNB::on_IUNB_status_prepared(QString status)
+    // Next clicks are likely near this one
+    prefetch_near(index.row(), core.pref()->book_info.prefetch_near);
+    run_prefetch();
+} // !void IUNB::on_W_unread_list_clicked(...)
+
+// Show the most important of the latest log records in status bar
+void IUNB::show_status()
 {
-    static std::ofstream log("./rsrc/iunb.txt", std::ios::app);
-    log << status.toStdString() << std::endl;
+    std::string text;
+    size_t count;
+    if (!core.log().summary(text, count)) return;
 
+    QString status = QString::fromUtf8(text.c_str(), text.size());
+    // Others are in log file
+    if (count > 1)
+    {
+        status.append(" (+").append(QString::number(count-1)).append(")");
+    }
     ui->SB_status->showMessage(status);
-} // !void IUNB::on_IUNB_status_prepared(...)
+} // !void IUNB::show_status()
 
-// Add book to list widget
-void IUNB::on_IUNB_book_found(QListWidgetItem *item)
+// Add found books to list
+void IUNB::on_IUNB_books_found()
 {
-    ui->W_unread_list->addItem(item);
-} // !void IUNB::on_IUNB_book_found(...)
+    std::vector<found_book> batch;
+    {
+        std::lock_guard<std::mutex> lock(found_mutex);
+        batch.swap(found);
+    }
+
+    const metrics::clock::time_point now = metrics::clock::now();
+    std::vector<book_list::book> added;
+    added.reserve(batch.size());
+    for (found_book &i : batch)
+    {
+        core.timings().record(metrics::unread, metrics::ui, now - i.sent);
+
+        // Found by previous search
+        if (i.search != search) continue;
+        added.push_back(std::move(i.book));
+    }
+
+    // One insert for all of them
+    const int first_row = books->rowCount();
+    books->append(added);
+
+    // The first books are likely clicked first
+    const int first = static_cast<int>(core.pref()->book_info.prefetch_first);
+    if (first_row >= first) return;
+    for (int row = first_row; row < first && row < books->rowCount(); ++row)
+    {
+        prefetch_queue.push_back(books->at(row).id);
+    }
+    run_prefetch();
+} // !void IUNB::on_IUNB_books_found()
 
 // Update cookie
 void IUNB::on_IUNB_cookie_updated(QByteArray new_cookie)
 {
-    emit status_prepared("Cookie: Updating");
+    core.log().write(logger::info, "Cookie: Updating");
 
-    wait_for_tasks();
-    cookie = new_cookie.data();
+    // Running tasks use old cookie
+    core.cancel_tasks();
+    core.set_cookie(new_cookie.data());
 
-    emit status_prepared("Cookie: Updated");
+    core.log().write(logger::info, "Cookie: Updated");
 } // !void IUNB::on_IUNB_cookie_updated(...)
 
 // Update book's info
-void IUNB::on_IUNB_book_info_updated(QListWidgetItem *item)
+void IUNB::on_IUNB_book_info_updated(qulonglong id, QString descr, qint64 sent)
 {
-    // Load new info only if it is current item
-    emit status_prepared("Book info: OK");
-    if (ui->W_unread_list->currentItem() == item)
+    core.log().write(logger::info, "Book info: OK");
+
+    // Excluded while it was loading
+    const int row = books->row_of(id);
+    if (row < 0) return;
+    books->at(row).descr = descr;
+
+    // Load new info only if it is current book
+    if (ui->W_unread_list->currentIndex().row() == row)
     {
-        pit_inf it_inf = item->data(Qt::UserRole).value<pit_inf>();
-        ui->TB_book_info->setText(it_inf->str);
+        ui->TB_book_info->setText(descr);
+        core.timings().record(metrics::book_info, metrics::ui,
+                              metrics::clock::now() - metrics::clock::time_point(
+                                  metrics::clock::duration(sent)));
     }
 } // !void IUNB::on_IUNB_book_info_updated(...)
 
+// Write stats to file from settings
+void IUNB::export_metrics()
+{
+    core.export_metrics();
+} // !void IUNB::export_metrics()
+
+// Request next prefetched book's info
+void IUNB::on_IUNB_book_info_done(qulonglong id, bool prefetch)
+{
+    const int row = books->row_of(id);
+    if (row >= 0) books->at(row).loading = false;
+
+    if (prefetch && prefetching) --prefetching;
+    run_prefetch();
+} // !void IUNB::on_IUNB_book_info_done(...)
+
 // Add book to exclude list
 void IUNB::add_exclude_book(QAction *action)
 {
     // Exclude file list related to this action
-    pofstr shp_ofstr = action->data().value<pofstr>();
-    // List with selected items, if any
-    auto sel_items = ui->W_unread_list->selectedItems();
-
-    unsigned long long id;
-    static auto session = time(nullptr);
-    // Add to related exclude list new book id and delete book from list widget
-    for (QListWidgetItem * i : sel_items)
+    std::string list_filename = action->data().toString().toStdString();
+    // Selected rows, if any
+    const QModelIndexList selected =
+            ui->W_unread_list->selectionModel()->selectedRows();
+    if (selected.isEmpty()) return;
+
+    // Selected books, written in background
+    std::vector<engine::excl_book> excl_books;
+    std::unordered_set<unsigned long long> ids;
+    std::vector<int> rows;
+    for (const QModelIndex &index : selected)
     {
-        id = i->data(Qt::UserRole).value<pit_inf>()->id;
-       *shp_ofstr << id
-                  << ';'
-                  << i->text().toStdString()
-                  << " @ "
-                  << session
-                  << std::endl;
-        new_excl_id.emplace(id);
-        delete i;
+        const book_list::book &b = books->at(index.row());
+        engine::excl_book book;
+        book.id = b.id;
+        book.title = b.title.toStdString();
+        excl_books.push_back(book);
+        ids.insert(b.id);
+        rows.push_back(index.row());
     }
 
-} // !void IUNB::add_ecxlude_book(...)
+    // Running searches skip these books at once
+    core.exclude(list_filename, excl_books);
+
+    // and they aren't prefetched
+    prefetch_queue.erase(std::remove_if(prefetch_queue.begin(),
+                                        prefetch_queue.end(),
+                                        [&ids](unsigned long long id)
+    {
+        return ids.count(id) != 0;
+    }), prefetch_queue.end());
+
+    // Delete books from list at once
+    books->remove(rows);
+} // !void IUNB::add_exclude_book(...)
+
+// Remember changed file and wait for its next changes
+void IUNB::file_changed(const QString &path)
+{
+    if (path == QString::fromStdString(core.settings_filename()))
+        reload_pref = true;
+    else
+        reload_lists = true;
+
+    // Editors write file in several steps, it is read after the last one
+    reload_timer->start();
+} // !void IUNB::file_changed(...)
+
+// Reload changed files
+void IUNB::reload_files()
+{
+    // Replaced file is watched again
+    watch_files();
+
+    if (reload_pref) core.async_reload_settings();
+    if (reload_lists)
+    {
+        core.async_reload_lists([this]()
+        {
+            emit lists_reloaded();
+        });
+    }
+    reload_pref = reload_lists = false;
+} // !void IUNB::reload_files()
+
+// Make actions for reloaded exclude lists
+void IUNB::on_IUNB_lists_reloaded()
+{
+    make_list_actions();
+} // !void IUNB::on_IUNB_lists_reloaded()
 
 // !IUNB Slots
 ///////////////////////////////////////////////////////////////////////////////
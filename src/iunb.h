@@ -6,26 +6,16 @@
 
 #include <QMainWindow>
 
-// Qt MOC conflicts with boost
-#ifndef Q_MOC_RUN
+// Networking, parsing and exclusion without GUI
+#include "engine.h"
+// Unread books for list view
+#include "book_list.h"
 
-// Network:
-#include <boost/asio.hpp>
-
-// Application preferences
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/xml_parser.hpp>
-
-#endif // Q_MOC_RUN
-
-// Holds exception from worker threads in list<future<void>>
-#include <future>
-// I use shared_ptr in QVariant to eliminate duplication
-#include <memory>
-// Load\save settings, lists, etc.
-#include <fstream>
-// Stores book's id to exclude
-#include <unordered_set>
+// Books found by workers, waiting for GUI thread
+#include <mutex>
+#include <vector>
+// Books waiting for prefetch
+#include <deque>
 
 // !Headers
 ///////////////////////////////////////////////////////////////////////////////
@@ -34,8 +24,10 @@
 // Forward declarations
 ///////////////////////////////////////////////////////////////////////////////
 
-class QListWidgetItem;
 class QActionGroup;
+class QModelIndex;
+class QFileSystemWatcher;
+class QTimer;
 
 // !Forward declarations
 ///////////////////////////////////////////////////////////////////////////////
@@ -48,112 +40,86 @@ namespace Ui
 class IUNB : public QMainWindow
 {
     Q_OBJECT
-public:
-    // Qt::UserRole data in QListWidgetItem's QVariant
-    struct item_info
+private:
+    // Book found by worker thread
+    struct found_book
     {
-    public:
-        item_info(unsigned long long in_id):id(in_id){}
-    public:
-        // Book's description
-        QString str;
-        // Book's id
-        unsigned long long id;
-    }; // !struct item_info
-
-    // QVariant likes to copy everything everytime
-    // but I - don't
-    typedef std::shared_ptr<item_info> pit_inf;
-    typedef std::shared_ptr<std::ofstream> pofstr;
+        book_list::book book;
+        // Number of search which found the book
+        unsigned search;
+        // When book was sent to GUI thread
+        metrics::clock::time_point sent;
+    };
 
 private:
-    // All configuration file's names are made from this string
-    std::string username;
-
-    // Needed for boost IO operations
-    boost::asio::io_service io_service;
+    // Site, parsers, exclude lists and settings
+    engine core;
 
-    // Stores preferences from $username.pref.xml
-    boost::property_tree::ptree xml_pref;
+    // Actions related to exclude lists
+    QActionGroup * excl_lists;
 
-    // Stores auth
-    std::string cookie;
+    // Settings and lists files of user, reloaded when they are changed
+    QFileSystemWatcher *watcher;
+    // Files are reloaded after the last change of several
+    QTimer *reload_timer;
+    bool reload_pref;
+    bool reload_lists;
 
-    // Holds exception from worker threads, if any
-    // also I can wait for threads to finish
-    std::list<std::future<void>> tasks_list;
+    // Unread books in W_unread_list
+    book_list *books;
 
-    // Stores book's id to exclude
-    std::unordered_set<unsigned long long> excl_id;
+    // Number of the last search, books of previous ones are dropped
+    unsigned search;
+    // Token of the last search, only it is cancelled by the next one
+    cancel_token::ptoken search_token;
 
-    // Stores new book's id to exclude
-    // unloads to main (excl_id) list when necessary
-    std::unordered_set<unsigned long long> new_excl_id;
+    // Books found by workers and not added to list yet
+    // books_found is emitted only for the first of them
+    std::mutex found_mutex;
+    std::vector<found_book> found;
 
-    // Actions related to exclude lists
-    QActionGroup * excl_lists;
+    // Books to get description for before they are clicked
+    std::deque<unsigned long long> prefetch_queue;
+    // and number of those requests running now
+    size_t prefetching;
 
     Ui::IUNB *ui;
 
 private:
-    // Wait for threads to finish
-    // This makes possible to change settings, cookie, etc without reload
-    void wait_for_tasks();
-
-    // Load settings or create default
-    void load_settings();
-
-    // Load exclude lists
-    void load_lists();
+    // Load settings and exclude lists of user,
+    // and make actions for exclude lists
+    void load_settings(const std::string &username);
 
-    //Unload new exclude book's id
-    void unload_new_excl_id();
+    // Make action for every exclude list
+    void make_list_actions();
 
-    // Connect, send auth info, save parsed reply to cookie to be auth.
-    void authorize (const std::string &login,
-                    const std::string &password);
+    // Watch settings and lists files of user, if they aren't watched
+    void watch_files();
 
     // Run authorize (...) asynchronously
     void async_authorize (const std::string &login,
                           const std::string &password);
 
-    // Waiting either 1 second or until socket buffer is full
-    // and return size of available bytes
-    static size_t wait_for_reply (const boost::asio::ip::tcp::socket &socket);
-
-    // Add to out_str cookie sequence from src,
-    // that begins with beg_req and end with ';'
-    static void add_cookie(std::string &out_str,
-                           const std::string &src,
-                           const std::string &beg_req);
-
-    // Send GET with cookie
-    // Get reply and parse it for unread books
-    // Repeat until count(unread books) < num from xml settings
-    void get_unread();
-
     // Run get_unread() asynchronously
     void async_get_unread();
 
-    // Parse string for unread books
-    void parse_for_unread(const std::string &src, size_t beg_search,
-                          size_t &out_count);
+    // Pass unread book to GUI thread, called by worker
+    void add_unread(unsigned long long id, const char *title, size_t size,
+                    unsigned search);
 
-    // Get book's description
-    void get_book_info(QListWidgetItem *item);
+    // Get book's description asynchronously
+    // book_info_done is emitted when it is finished
+    void async_get_book_info(book_list::book &b, bool prefetch);
 
-    // Run get_book_info() asynchronously
-    void async_get_book_info(QListWidgetItem *item);
+    // Set book's description from disk cache
+    // Return true if it must be requested from site
+    bool load_cached_info(book_list::book &b);
 
-    // Get book's description from reply
-    bool parse_for_descr(const std::string &src, std::string &out_src,
-                         size_t beg_serch);
+    // Queue book in row and its neighbours for prefetch
+    void prefetch_near(int row, size_t num);
 
-    // Append to string html node with tag if "with" == true
-    static std::string &add_by_tag(const std::string &src,
-                                   std::string &out_str,
-                                   std::string o_tag, size_t &in_beg_pos,
-                                   bool with);
+    // Request queued descriptions while budget allows
+    void run_prefetch();
 public:
 
     explicit IUNB(QWidget *parent = 0);
@@ -161,38 +127,45 @@ public:
     ~IUNB();
 
 signals:
-    // Signal to change status in status bar
-    void status_prepared(QString status);
-    // Signal to add unread book in list widget
-    void book_found (QListWidgetItem *item);
+    // Signal to add found books to list
+    void books_found();
     // Signal to update cookie
     void cookie_updated(QByteArray new_cookie);
     // Signal to display new info about book
-    void book_info_updated(QListWidgetItem *item);
+    // sent is metrics::clock time, when it was emitted
+    void book_info_updated(qulonglong id, QString descr, qint64 sent);
+    // Signal that request of book's info is finished, successful or not
+    void book_info_done(qulonglong id, bool prefetch);
+    // Signal that exclude lists are reloaded
+    void lists_reloaded();
 
 private slots:
     // Authorize Action
     void on_A_Authorize_triggered();
     // Get Unread Action
     void on_A_Get_Unread_triggered();
-    // Load item's book description
-    void on_W_unread_list_itemClicked(QListWidgetItem *item);
-    // Update status bar and log to file
-    void on_IUNB_status_prepared(QString status);
-    // Add book to list widget
-    void on_IUNB_book_found(QListWidgetItem *item);
+    // Load clicked book's description
+    void on_W_unread_list_clicked(const QModelIndex &index);
+    // Show the most important of the latest log records in status bar
+    void show_status();
+    // Write stats to file from settings
+    void export_metrics();
+    // Add found books to list
+    void on_IUNB_books_found();
     // Update cookie
     void on_IUNB_cookie_updated(QByteArray new_cookie);
     // Update book's info
-    void on_IUNB_book_info_updated(QListWidgetItem *item);
+    void on_IUNB_book_info_updated(qulonglong id, QString descr, qint64 sent);
+    // Request next prefetched book's info
+    void on_IUNB_book_info_done(qulonglong id, bool prefetch);
     // Add book to exclude list
     void add_exclude_book (QAction *action);
+    // Remember changed file and wait for its next changes
+    void file_changed(const QString &path);
+    // Reload changed files
+    void reload_files();
+    // Make actions for reloaded exclude lists
+    void on_IUNB_lists_reloaded();
 };
 
-// QVariant is too proud of himself to be really Variant
-// so this allows QVariant to contain shared_ptr
-// to struct with book's id and description
-Q_DECLARE_METATYPE(IUNB::pit_inf)
-Q_DECLARE_METATYPE(IUNB::pofstr)
-
 #endif // IUNB_H
@@ -0,0 +1,225 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "list_writer.h"
+
+// fopen, fwrite
+#include <cstdio>
+#include <cerrno>
+
+// Sync file to disk, cut torn batch
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// list_writer Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+list_writer::list_writer():
+    batch_size(0),
+    failed(false),
+    writes(0),
+    writing(false),
+    flushing(false),
+    stopping(false),
+    max_size(4096),
+    max_delay(200)
+{
+    thread = std::thread(&list_writer::run, this);
+} // !list_writer::list_writer()
+
+// Write everything and stop thread
+list_writer::~list_writer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+} // !list_writer::~list_writer()
+
+// Write batch when it has max_size bytes or is max_delay old
+void list_writer::set_limits(size_t max_size,
+                             std::chrono::milliseconds max_delay)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->max_size = max_size;
+        this->max_delay = max_delay;
+    }
+    wake.notify_one();
+} // !void list_writer::set_limits(...)
+
+// Report failed writes to on_error
+void list_writer::set_error_handler(error_handler on_error)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->on_error = std::move(on_error);
+} // !void list_writer::set_error_handler(...)
+
+// Append record to file, record is written as is
+void list_writer::append(const std::string &filename,
+                         const std::string &record)
+{
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!batch_size) batch_time = clock::now();
+        batch[filename] += record;
+        batch_size += record.size();
+        full = batch_size >= max_size;
+    }
+    // Thread sleeps till batch is old enough otherwise
+    if (full) wake.notify_one();
+} // !void list_writer::append(...)
+
+// Wait until everything appended is written
+void list_writer::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!batch_size && !writing) return;
+
+    // Write in progress may have missed the latest records
+    const unsigned long long target = writes + (writing ? 2 : 1);
+    flushing = true;
+    wake.notify_one();
+    written.wait(lock, [this, target]()
+    {
+        return (!batch_size && !writing) || writes >= target;
+    });
+} // !void list_writer::flush()
+
+// Call f for records of every file, that aren't written yet
+void list_writer::unwritten(
+        const std::function<void (const std::string &records)> &f)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &i : in_flight) f(i.second);
+    for (auto &i : batch) f(i.second);
+} // !void list_writer::unwritten(...)
+
+// !list_writer Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// list_writer Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Thread function
+void list_writer::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        if (batch_size)
+        {
+            // Failed batch waits for retry, however big it is
+            const clock::time_point due =
+                    failed ? retry_time : batch_time + max_delay;
+            if (stopping || flushing || clock::now() >= due ||
+                (!failed && batch_size >= max_size))
+            {
+                write_batch(lock);
+                // The last try, records are lost and reported
+                if (stopping && failed) break;
+                continue;
+            }
+            wake.wait_until(lock, due);
+        }
+        else
+        {
+            if (stopping) break;
+            wake.wait(lock);
+        }
+    }
+} // !void list_writer::run()
+
+// Write batch of every file, mutex is unlocked meanwhile
+void list_writer::write_batch(std::unique_lock<std::mutex> &lock)
+{
+    // Records stay visible to unwritten() until they are written
+    std::map<std::string, std::string> &files = in_flight;
+    files.swap(batch);
+    batch_size = 0;
+    writing = true;
+    // This write answers flush() requests made so far
+    flushing = false;
+    const error_handler report = on_error;
+
+    lock.unlock();
+    // Files, that weren't written, and their errors
+    std::map<std::string, int> errors;
+    for (auto &i : files)
+    {
+        const int error = write_file(i.first, i.second);
+        if (error) errors[i.first] = error;
+    }
+    if (report)
+    {
+        for (auto &i : errors) report(i.first, i.second);
+    }
+    lock.lock();
+
+    // Records appended meanwhile go after failed ones
+    for (auto &i : errors)
+    {
+        std::string &data = files[i.first];
+        if (!batch_size) batch_time = clock::now();
+        batch_size += data.size();
+        batch[i.first].insert(0, data);
+    }
+    files.clear();
+    failed = !errors.empty();
+    if (failed) retry_time = clock::now() + max_delay;
+
+    ++writes;
+    writing = false;
+    written.notify_all();
+} // !void list_writer::write_batch(...)
+
+// Append data to file and sync it to disk
+int list_writer::write_file(const std::string &filename,
+                            const std::string &data)
+{
+    FILE *file = fopen(filename.c_str(), "ab");
+    if (!file) return errno ? errno : EIO;
+
+    // Size before batch, torn batch is cut to it
+    long old_size = -1;
+    if (!fseek(file, 0, SEEK_END)) old_size = ftell(file);
+
+    errno = 0;
+    bool ok = old_size >= 0 &&
+              fwrite(data.data(), 1, data.size(), file) == data.size() &&
+              !fflush(file);
+#ifdef _WIN32
+    ok = ok && !_commit(_fileno(file));
+#else
+    ok = ok && !fsync(fileno(file));
+#endif
+    int error = ok ? 0 : (errno ? errno : EIO);
+
+    if (!ok && old_size >= 0)
+    {
+#ifdef _WIN32
+        _chsize(_fileno(file), old_size);
+#else
+        // Error of cut is lost, error of write is reported
+        if (ftruncate(fileno(file), old_size)) {}
+#endif
+    }
+
+    if (fclose(file) && !error) error = errno ? errno : EIO;
+    return error;
+} // !int list_writer::write_file(...)
+
+// !list_writer Private functions
+///////////////////////////////////////////////////////////////////////////////
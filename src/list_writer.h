@@ -0,0 +1,108 @@
+#ifndef LIST_WRITER_H
+#define LIST_WRITER_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Records are written by background thread
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+// Time threshold of batch
+#include <chrono>
+// Filename - its records
+#include <map>
+#include <string>
+// Failed write is reported
+#include <functional>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Appends records to list files in background
+// Records are batched and written when batch is big or old enough.
+// Every batch is written to file at once and synced to disk,
+// so file is never left with a part of batch after crash.
+// Batch that failed to be written is kept and written again later.
+class list_writer
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    // Receives file and errno of failed write, called by writer's thread
+    typedef std::function<void (const std::string &filename, int error)>
+            error_handler;
+
+public:
+    list_writer();
+
+    // Write everything and stop thread
+    ~list_writer();
+
+    // Write batch when it has max_size bytes or is max_delay old
+    void set_limits(size_t max_size, std::chrono::milliseconds max_delay);
+
+    // Report failed writes to on_error, must be set before append()
+    void set_error_handler(error_handler on_error);
+
+    // Append record to file, record is written as is
+    void append(const std::string &filename, const std::string &record);
+
+    // Wait until everything appended is written,
+    // or until write of it failed once
+    void flush();
+
+    // Call f for records of every file, that aren't written yet,
+    // including those being written now
+    void unwritten(const std::function<void (const std::string &records)> &f);
+
+private:
+    // Thread function
+    void run();
+
+    // Write batch of every file, mutex is unlocked meanwhile
+    // Records of failed files go back to batch
+    void write_batch(std::unique_lock<std::mutex> &lock);
+
+    // Append data to file and sync it to disk
+    // File is cut back to its old size, if data isn't written whole
+    // Return 0 or errno
+    static int write_file(const std::string &filename,
+                          const std::string &data);
+
+private:
+    std::mutex mutex;
+    // New records or flush request
+    std::condition_variable wake;
+    // Batch is written
+    std::condition_variable written;
+
+    // Filename - records not written yet
+    std::map<std::string, std::string> batch;
+    // Filename - records being written now, changed only under mutex
+    std::map<std::string, std::string> in_flight;
+    size_t batch_size;
+    // When the first record of batch was appended
+    clock::time_point batch_time;
+
+    // The last write failed, next one is after retry_time
+    bool failed;
+    clock::time_point retry_time;
+    // Number of finished writes, flush() waits for the next one
+    unsigned long long writes;
+
+    // Batch is being written now
+    bool writing;
+    // Somebody waits in flush()
+    bool flushing;
+    bool stopping;
+
+    error_handler on_error;
+
+    size_t max_size;
+    std::chrono::milliseconds max_delay;
+
+    std::thread thread;
+}; // !class list_writer
+
+#endif // LIST_WRITER_H
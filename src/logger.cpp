@@ -0,0 +1,243 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "logger.h"
+
+// Local time of record
+#include <ctime>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Record format
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    const char *level_name(logger::level lvl)
+    {
+        switch (lvl)
+        {
+        case logger::debug: return "DEBUG";
+        case logger::info: return "INFO ";
+        case logger::warning: return "WARN ";
+        default: return "ERROR";
+        }
+    }
+} // !namespace
+
+// !Record format
+///////////////////////////////////////////////////////////////////////////////
+
+
+// logger Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Capacity of ring buffer is rounded up to power of 2
+logger::logger(const std::string &filename, size_t capacity):
+    mask(1),
+    write_pos(0),
+    read_pos(0),
+    dropped(0),
+    stopping(false),
+    sleeping(false),
+    summary_level(debug),
+    summary_count(0)
+{
+    while (mask < capacity) mask <<= 1;
+    cells.reset(new cell[mask]);
+    for (size_t i = 0; i < mask; ++i) cells[i].seq = i;
+    --mask;
+
+    file = fopen(filename.c_str(), "ab");
+
+    thread = std::thread(&logger::run, this);
+} // !logger::logger(...)
+
+// Write everything and stop thread
+logger::~logger()
+{
+    stopping = true;
+    wake_drain();
+    thread.join();
+    if (file) fclose(file);
+} // !logger::~logger()
+
+// Add record, fields are " name=value" pairs made by field()
+void logger::write(level lvl, std::string text, std::string fields)
+{
+    // Take free cell
+    size_t pos = write_pos.load(std::memory_order_relaxed);
+    cell *c;
+    for (;;)
+    {
+        c = &cells[pos & mask];
+        size_t seq = c->seq.load(std::memory_order_acquire);
+        if (seq == pos)
+        {
+            if (write_pos.compare_exchange_weak(pos, pos+1,
+                                                std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        // Drain thread hasn't read this cell yet
+        else if (seq < pos)
+        {
+            ++dropped;
+            return;
+        }
+        else pos = write_pos.load(std::memory_order_relaxed);
+    }
+
+    c->rec.time = clock::now();
+    c->rec.thread = std::this_thread::get_id();
+    c->rec.lvl = lvl;
+    c->rec.text = std::move(text);
+    c->rec.fields = std::move(fields);
+    // and give it to drain thread
+    c->seq.store(pos+1, std::memory_order_release);
+    wake_drain();
+} // !void logger::write(...)
+
+// Text of the most important record since previous call
+// and number of records since then
+// Return false if there were no records
+bool logger::summary(std::string &out_text, size_t &out_count)
+{
+    std::lock_guard<std::mutex> lock(summary_mutex);
+    if (!summary_count) return false;
+
+    out_text = summary_text;
+    out_count = summary_count;
+    summary_level = debug;
+    summary_count = 0;
+    return true;
+} // !bool logger::summary(...)
+
+// !logger Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// logger Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Take record from ring buffer, only drain thread calls this
+bool logger::pop(record &out_rec)
+{
+    cell &c = cells[read_pos & mask];
+    if (c.seq.load(std::memory_order_acquire) != read_pos+1) return false;
+
+    out_rec = std::move(c.rec);
+    // Cell is free for the next round
+    c.seq.store(read_pos+mask+1, std::memory_order_release);
+    ++read_pos;
+    return true;
+} // !bool logger::pop(...)
+
+// Is there a record to pop, only drain thread calls this
+bool logger::ready() const
+{
+    const cell &c = cells[read_pos & mask];
+    return c.seq.load(std::memory_order_acquire) == read_pos+1;
+} // !bool logger::ready() const
+
+// Wake drain thread, if it sleeps
+void logger::wake_drain()
+{
+    // Record or stop is seen by drain thread before it sleeps,
+    // or sleeping is seen here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!sleeping.load(std::memory_order_relaxed)) return;
+
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    wake.notify_one();
+} // !void logger::wake_drain()
+
+// Drain thread function
+void logger::run()
+{
+    std::string batch;
+    record rec;
+    for (;;)
+    {
+        // Records written before stop are still written to file
+        const bool stop = stopping;
+
+        batch.clear();
+        size_t num = 0;
+        while (pop(rec))
+        {
+            format(rec, batch);
+            ++num;
+
+            if (rec.lvl < info) continue;
+            std::lock_guard<std::mutex> lock(summary_mutex);
+            ++summary_count;
+            // Warnings and errors aren't hidden by next messages
+            if (rec.lvl >= summary_level)
+            {
+                summary_level = rec.lvl;
+                summary_text = rec.text;
+            }
+        }
+
+        size_t lost = dropped.exchange(0);
+        if (lost) batch += "Log: Dropped records: " + std::to_string(lost) + '\n';
+
+        if (file && batch.size())
+        {
+            fwrite(batch.data(), 1, batch.size(), file);
+            fflush(file);
+        }
+
+        if (stop) break;
+        if (num) continue;
+
+        // Sleep until the next record or stop
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!ready() && !stopping) wake.wait(lock);
+        sleeping.store(false, std::memory_order_relaxed);
+    }
+} // !void logger::run()
+
+// Append record to batch
+void logger::format(const record &rec, std::string &out_batch)
+{
+    // 2014-01-31 23:59:59.999
+    const std::time_t time = clock::to_time_t(rec.time);
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &time);
+#else
+    localtime_r(&time, &tm);
+#endif
+    char stamp[32];
+    size_t size = strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                rec.time.time_since_epoch()).count() % 1000;
+    stamp[size++] = '.';
+    stamp[size++] = static_cast<char>('0' + ms/100);
+    stamp[size++] = static_cast<char>('0' + ms/10%10);
+    stamp[size++] = static_cast<char>('0' + ms%10);
+    stamp[size] = '\0';
+
+    std::ostringstream thread;
+    thread << rec.thread;
+
+    out_batch += stamp;
+    out_batch += " [";
+    out_batch += thread.str();
+    out_batch += "] ";
+    out_batch += level_name(rec.lvl);
+    out_batch += ' ';
+    out_batch += rec.text;
+    out_batch += rec.fields;
+    out_batch += '\n';
+} // !void logger::format(...)
+
+// !logger Private functions
+///////////////////////////////////////////////////////////////////////////////
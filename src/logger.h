@@ -0,0 +1,129 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Ring buffer is shared by writers and drain thread without locks
+#include <atomic>
+#include <thread>
+// Status summary is taken by GUI
+#include <mutex>
+// Idle drain thread waits for records
+#include <condition_variable>
+// Time of record
+#include <chrono>
+// Ring buffer cells
+#include <memory>
+#include <string>
+// Values of fields
+#include <sstream>
+// Log file
+#include <cstdio>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Log which never blocks the thread that writes to it
+// Records go to a bounded lock-free ring buffer, and background thread
+// moves them to file in batches, with time, thread id and level.
+// If ring buffer is full, record is dropped and counted.
+// Idle drain thread sleeps until a record is written, writer locks
+// only to wake it.
+// The most important of the latest records is kept for status bar.
+class logger
+{
+public:
+    enum level { debug, info, warning, error };
+
+    typedef std::chrono::system_clock clock;
+
+public:
+    // Capacity of ring buffer is rounded up to power of 2
+    explicit logger(const std::string &filename, size_t capacity = 4096);
+
+    // Write everything and stop thread
+    ~logger();
+
+    // Add record, fields are " name=value" pairs made by field()
+    void write(level lvl, std::string text, std::string fields = std::string());
+
+    // " name=value" for write()
+    template <class T>
+    static std::string field(const char *name, const T &value)
+    {
+        std::ostringstream out;
+        out << ' ' << name << '=' << value;
+        return out.str();
+    }
+
+    // Text of the most important record since previous call
+    // and number of records since then
+    // Return false if there were no records
+    bool summary(std::string &out_text, size_t &out_count);
+
+private:
+    struct record
+    {
+        clock::time_point time;
+        std::thread::id thread;
+        level lvl;
+        std::string text;
+        std::string fields;
+    };
+
+    // Cell of ring buffer, seq tells who may use it now
+    struct cell
+    {
+        std::atomic<size_t> seq;
+        record rec;
+    };
+
+private:
+    // Take record from ring buffer, only drain thread calls this
+    bool pop(record &out_rec);
+
+    // Is there a record to pop, only drain thread calls this
+    bool ready() const;
+
+    // Wake drain thread, if it sleeps
+    void wake_drain();
+
+    // Drain thread function
+    void run();
+
+    // Append record to batch
+    static void format(const record &rec, std::string &out_batch);
+
+private:
+    std::unique_ptr<cell[]> cells;
+    size_t mask;
+
+    // Next cell to write, shared by writers
+    std::atomic<size_t> write_pos;
+    // Next cell to read, drain thread only
+    size_t read_pos;
+
+    // Records lost because ring buffer was full
+    std::atomic<size_t> dropped;
+
+    std::atomic<bool> stopping;
+
+    // Drain thread waits for records, writers notify it
+    // only when it is asleep
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::atomic<bool> sleeping;
+
+    // Summary for status bar
+    std::mutex summary_mutex;
+    std::string summary_text;
+    level summary_level;
+    size_t summary_count;
+
+    FILE *file;
+
+    std::thread thread;
+}; // !class logger
+
+#endif // LOGGER_H
@@ -0,0 +1,244 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "metrics.h"
+
+// Text format
+#include <sstream>
+#include <fstream>
+// Connection lives until reply is sent
+#include <memory>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Names in exported text
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    const char *path_names[] = { "authorize", "unread", "book_info" };
+
+    const char *phase_names[] =
+    {
+        "dns", "connect", "first_byte", "body", "parse", "ui"
+    };
+
+    // Connection to metrics endpoint
+    struct metrics_session
+    {
+        explicit metrics_session(boost::asio::io_service &io_service):
+            socket(io_service) {}
+
+        boost::asio::ip::tcp::socket socket;
+        boost::asio::streambuf request;
+        std::string reply;
+    };
+} // !namespace
+
+// !Names in exported text
+///////////////////////////////////////////////////////////////////////////////
+
+
+// histogram Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+histogram::histogram():
+    total(0),
+    sum_us(0)
+{
+    for (auto &i : buckets) i = 0;
+} // !histogram::histogram()
+
+//
+void histogram::record(std::chrono::microseconds value)
+{
+    const std::uint64_t us = value.count() < 0 ? 0 : value.count();
+    buckets[index(us)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum_us.fetch_add(us, std::memory_order_relaxed);
+} // !void histogram::record(...)
+
+// Bucket contains values less than this
+std::uint64_t histogram::upper_bound(size_t i)
+{
+    if (i < sub_buckets) return i+1;
+    const size_t shift = (i-sub_buckets)/sub_buckets;
+    const std::uint64_t sub = (i-sub_buckets)%sub_buckets;
+    return (sub_buckets+sub+1) << shift;
+} // !std::uint64_t histogram::upper_bound(...)
+
+// !histogram Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// histogram Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Bucket of value
+size_t histogram::index(std::uint64_t value)
+{
+    if (value < sub_buckets) return static_cast<size_t>(value);
+
+    // value is in [8 << shift, 16 << shift)
+    size_t shift = 0;
+    while (value >> shift >= 2*sub_buckets) ++shift;
+    const size_t i = sub_buckets + shift*sub_buckets +
+            static_cast<size_t>((value >> shift) - sub_buckets);
+    return i < bucket_count ? i : bucket_count-1;
+} // !size_t histogram::index(...)
+
+// !histogram Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// metrics Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+metrics::metrics(boost::asio::io_service &io_service):
+    io_service(io_service),
+    acceptor(io_service)
+{
+} // !metrics::metrics(...)
+
+//
+metrics::~metrics()
+{
+    boost::system::error_code ec;
+    acceptor.close(ec);
+} // !metrics::~metrics()
+
+//
+void metrics::record(path p, phase ph, clock::duration value)
+{
+    hists[p][ph].record(
+                std::chrono::duration_cast<std::chrono::microseconds>(value));
+} // !void metrics::record(...)
+
+// All histograms in Prometheus text format
+std::string metrics::text() const
+{
+    std::ostringstream out;
+    out << "# HELP iunb_phase_seconds Time of request phases\n"
+           "# TYPE iunb_phase_seconds histogram\n";
+
+    for (size_t p = 0; p < path_count; ++p)
+    {
+        for (size_t ph = 0; ph < phase_count; ++ph)
+        {
+            const histogram &hist = hists[p][ph];
+            const std::uint64_t count = hist.count();
+            if (!count) continue;
+
+            std::ostringstream labels;
+            labels << "path=\"" << path_names[p]
+                   << "\",phase=\"" << phase_names[ph] << '"';
+
+            // Only buckets with values, cumulative
+            std::uint64_t cumulative = 0;
+            for (size_t i = 0; i < histogram::bucket_count; ++i)
+            {
+                const std::uint64_t num = hist.bucket(i);
+                if (!num) continue;
+                cumulative += num;
+                out << "iunb_phase_seconds_bucket{" << labels.str()
+                    << ",le=\"" << histogram::upper_bound(i)/1e6 << "\"} "
+                    << cumulative << '\n';
+            }
+            out << "iunb_phase_seconds_bucket{" << labels.str()
+                << ",le=\"+Inf\"} " << count << '\n'
+                << "iunb_phase_seconds_sum{" << labels.str() << "} "
+                << hist.sum()/1e6 << '\n'
+                << "iunb_phase_seconds_count{" << labels.str() << "} "
+                << count << '\n';
+        }
+    }
+    return out.str();
+} // !std::string metrics::text() const
+
+// Write text() to file, return false if it fails
+bool metrics::write_file(const std::string &filename) const
+{
+    std::ofstream file(filename, std::ios::trunc);
+    file << text();
+    return static_cast<bool>(file);
+} // !bool metrics::write_file(...) const
+
+// Serve text() on 127.0.0.1:port, 0 - stop serving
+// Connections are handled by io_service threads
+void metrics::serve(unsigned short port)
+{
+    // Acceptor is used by io_service threads only
+    io_service.post([this, port]()
+    {
+        boost::system::error_code ec;
+        acceptor.close(ec);
+        if (!port) return;
+
+        using boost::asio::ip::tcp;
+        const tcp::endpoint ep(boost::asio::ip::address_v4::loopback(), port);
+        acceptor.open(ep.protocol(), ec);
+        if (!ec) acceptor.set_option(tcp::acceptor::reuse_address(true), ec);
+        if (!ec) acceptor.bind(ep, ec);
+        if (!ec) acceptor.listen(tcp::socket::max_connections, ec);
+        if (ec)
+        {
+            acceptor.close(ec);
+            return;
+        }
+        async_accept();
+    });
+} // !void metrics::serve(...)
+
+// !metrics Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// metrics Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Accept next connection to endpoint
+void metrics::async_accept()
+{
+    auto session = std::make_shared<metrics_session>(io_service);
+    acceptor.async_accept(session->socket,
+                          [this, session](const boost::system::error_code &ec)
+    {
+        // Acceptor is closed
+        if (ec == boost::asio::error::operation_aborted) return;
+        async_accept();
+        if (ec) return;
+
+        // Any request gets metrics
+        boost::asio::async_read_until(session->socket, session->request,
+                                      "\r\n\r\n",
+                                      [this, session](
+                                      const boost::system::error_code &ec,
+                                      size_t)
+        {
+            if (ec) return;
+            const std::string body = text();
+            session->reply = "HTTP/1.0 200 OK\r\n"
+                             "Content-Type: text/plain; version=0.0.4\r\n"
+                             "Content-Length: " +
+                             std::to_string(body.size()) +
+                             "\r\nConnection: close\r\n\r\n" + body;
+            boost::asio::async_write(session->socket,
+                                     boost::asio::buffer(session->reply),
+                                     [session](
+                                     const boost::system::error_code &,
+                                     size_t)
+            {
+                boost::system::error_code ec;
+                session->socket.shutdown(
+                            boost::asio::ip::tcp::socket::shutdown_both, ec);
+            });
+        });
+    });
+} // !void metrics::async_accept()
+
+// !metrics Private functions
+///////////////////////////////////////////////////////////////////////////////
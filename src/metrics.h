@@ -0,0 +1,105 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Counters are updated by worker threads without locks
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Network:
+#include <boost/asio.hpp>
+
+#endif // Q_MOC_RUN
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Histogram of durations in microseconds
+// Buckets are log-linear: every power of 2 is split into 8 buckets,
+// so error of any value is less than 12.5%, like in HDR histogram.
+class histogram
+{
+public:
+    // Values under 8 us have own buckets, then 8 buckets per power of 2
+    // up to 2^40 us
+    static const size_t sub_buckets = 8;
+    static const size_t bucket_count = sub_buckets + (40-3)*sub_buckets;
+
+public:
+    histogram();
+
+    void record(std::chrono::microseconds value);
+
+    // Number of values in bucket
+    std::uint64_t bucket(size_t i) const
+    { return buckets[i].load(std::memory_order_relaxed); }
+
+    // Bucket contains values less than this
+    static std::uint64_t upper_bound(size_t i);
+
+    std::uint64_t count() const
+    { return total.load(std::memory_order_relaxed); }
+
+    // Sum of values in microseconds
+    std::uint64_t sum() const
+    { return sum_us.load(std::memory_order_relaxed); }
+
+private:
+    // Bucket of value
+    static size_t index(std::uint64_t value);
+
+private:
+    std::atomic<std::uint64_t> buckets[bucket_count];
+    std::atomic<std::uint64_t> total;
+    std::atomic<std::uint64_t> sum_us;
+}; // !class histogram
+
+// Time of request phases for every kind of request
+// Exported in Prometheus text format to file or to loopback HTTP endpoint.
+class metrics
+{
+public:
+    // Kind of request
+    enum path { authorize, unread, book_info, path_count };
+
+    // Phase of request
+    enum phase { dns, connect, first_byte, body, parse, ui, phase_count };
+
+    typedef std::chrono::steady_clock clock;
+
+public:
+    explicit metrics(boost::asio::io_service &io_service);
+
+    ~metrics();
+
+    void record(path p, phase ph, clock::duration value);
+
+    // All histograms in Prometheus text format
+    std::string text() const;
+
+    // Write text() to file, return false if it fails
+    bool write_file(const std::string &filename) const;
+
+    // Serve text() on 127.0.0.1:port, 0 - stop serving
+    // Connections are handled by io_service threads
+    void serve(unsigned short port);
+
+private:
+    // Accept next connection to endpoint
+    void async_accept();
+
+private:
+    boost::asio::io_service &io_service;
+    boost::asio::ip::tcp::acceptor acceptor;
+
+    histogram hists[path_count][phase_count];
+}; // !class metrics
+
+#endif // METRICS_H
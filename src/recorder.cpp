@@ -0,0 +1,152 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "recorder.h"
+
+// Fixture files
+#include <fstream>
+
+// Names of headers in lower case
+#include <boost/algorithm/string.hpp>
+#include <algorithm>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Session in headers
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Value of cookie in fixtures
+    const char replay_value[] = "replay";
+
+    // Header's value with values of its "name=value" pairs replaced
+    // Only the first pair, if all == false (attributes of Set-Cookie)
+    std::string redact_cookies(const std::string &value, bool all)
+    {
+        std::string out;
+        bool done = false;
+        for (size_t pos = 0; pos < value.size(); )
+        {
+            size_t pair_end = value.find(';', pos);
+            if (pair_end == value.npos) pair_end = value.size();
+            const size_t eq = value.find('=', pos);
+            if (!done && eq < pair_end)
+            {
+                out.append(value, pos, eq+1-pos);
+                out += replay_value;
+                done = !all;
+            }
+            else out.append(value, pos, pair_end-pos);
+            if (pair_end < value.size()) out += ';';
+            pos = pair_end+1;
+        }
+        return out;
+    }
+
+    // Replace cookies and drop Authorization in head of message
+    void redact_head(std::string &msg)
+    {
+        // Requests from pref.xml end lines with \n only
+        size_t head_end = std::min(msg.find("\n\n"), msg.find("\n\r\n"));
+        head_end = head_end == msg.npos ? msg.size() : head_end+1;
+
+        std::string out;
+        out.reserve(msg.size());
+        for (size_t beg = 0; beg < head_end; )
+        {
+            size_t next = msg.find('\n', beg);
+            next = next == msg.npos ? msg.size() : next+1;
+            size_t end = next;
+            while (end > beg && (msg[end-1] == '\n' || msg[end-1] == '\r'))
+                --end;
+
+            // Status or request line has no name
+            const size_t colon = msg.find(':', beg);
+            std::string name;
+            if (beg && colon < end) name.assign(msg, beg, colon-beg);
+            boost::to_lower(name);
+
+            if (name == "authorization")
+            {
+                beg = next;
+                continue;
+            }
+            if (name == "cookie" || name == "set-cookie")
+            {
+                out.append(msg, beg, colon+1-beg);
+                out += redact_cookies(msg.substr(colon+1, end-colon-1),
+                                      name == "cookie");
+                out.append(msg, end, next-end);
+            }
+            else out.append(msg, beg, next-beg);
+            beg = next;
+        }
+        out.append(msg, head_end, msg.npos);
+        msg.swap(out);
+    }
+} // !namespace
+
+// !Session in headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// recorder Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+recorder::recorder():
+    next(0)
+{
+} // !recorder::recorder()
+
+// Save exchanges to existing directory, empty - stop recording
+void recorder::open(const std::string &dir)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->dir = dir;
+    next = 0;
+    if (dir.empty()) return;
+
+    // Continue numbering of previous sessions
+    std::ifstream index(dir + "/index.txt");
+    std::string line;
+    while (getline(index, line)) ++next;
+} // !void recorder::open(...)
+
+//
+bool recorder::is_open()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return dir.size();
+} // !bool recorder::is_open()
+
+// Save one exchange without session
+void recorder::save(std::string request, std::string reply)
+{
+    redact_head(request);
+    redact_head(reply);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (dir.empty()) return;
+
+    std::string name = std::to_string(next++);
+    name.insert(0, name.size() < 6 ? 6-name.size() : 0, '0');
+
+    std::ofstream(dir + '/' + name + ".req", std::ios::binary) << request;
+    std::ofstream(dir + '/' + name + ".rsp", std::ios::binary) << reply;
+    std::ofstream(dir + "/index.txt", std::ios::app)
+            << name << ' ' << request_line(request) << '\n';
+} // !void recorder::save(...)
+
+// !recorder Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// First line of request: "GET /path HTTP/1.1"
+std::string request_line(const std::string &request)
+{
+    return request.substr(0, request.find_first_of("\r\n"));
+} // !std::string request_line(...)
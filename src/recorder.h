@@ -0,0 +1,47 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Exchanges are saved by worker threads
+#include <mutex>
+#include <string>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Saves raw HTTP exchanges to fixture directory
+// Every exchange is a pair of files: NNNNNN.req with request as sent
+// and NNNNNN.rsp with reply bytes as received from socket.
+// index.txt has "NNNNNN request-line" for every pair,
+// replay server finds replies by request line.
+// Session isn't saved: values of cookies in Cookie and Set-Cookie
+// are replaced with "replay", Authorization is dropped.
+// Authorize exchange isn't recorded at all, see engine::request.
+class recorder
+{
+public:
+    recorder();
+
+    // Save exchanges to existing directory, empty - stop recording
+    void open(const std::string &dir);
+
+    bool is_open();
+
+    // Save one exchange without session
+    void save(std::string request, std::string reply);
+
+private:
+    std::mutex mutex;
+
+    std::string dir;
+
+    // Number of the next exchange
+    unsigned next;
+}; // !class recorder
+
+// First line of request: "GET /path HTTP/1.1"
+std::string request_line(const std::string &request);
+
+#endif // RECORDER_H
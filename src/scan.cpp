@@ -0,0 +1,391 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "scan.h"
+
+// memchr, memcmp
+#include <cstring>
+
+// x86 has SSE2 and may have AVX2
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC allows AVX2 intrinsics in any function
+#define SCAN_AVX2_TARGET
+#else
+// GCC and clang need AVX2 to be enabled for function
+#define SCAN_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif // x86
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Scalar kernels
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    bool is_digit(char c)
+    {
+        return c>='0' && c<='9';
+    }
+
+    const char *find_byte_scalar(const char *beg, const char *end, char a)
+    {
+        const void *pos = memchr(beg, a, end-beg);
+        return pos ? static_cast<const char *>(pos) : end;
+    }
+
+    const char *find_byte2_scalar(const char *beg, const char *end,
+                                  char a, char b)
+    {
+        for (; beg != end; ++beg)
+        {
+            if (*beg == a || *beg == b) return beg;
+        }
+        return end;
+    }
+
+    const char *find_scalar(const char *beg, const char *end,
+                            const char *marker, size_t len)
+    {
+        if (!len) return beg;
+        for (const char *last = end - len + 1;
+             beg < last && (beg = find_byte_scalar(beg, last, *marker)) != last;
+             ++beg)
+        {
+            if (!memcmp(beg+1, marker+1, len-1)) return beg;
+        }
+        return end;
+    }
+
+    const char *find_digit_scalar(const char *beg, const char *end)
+    {
+        while (beg != end && !is_digit(*beg)) ++beg;
+        return beg;
+    }
+
+    const char *skip_digits_scalar(const char *beg, const char *end)
+    {
+        while (beg != end && is_digit(*beg)) ++beg;
+        return beg;
+    }
+} // !namespace
+
+// !Scalar kernels
+///////////////////////////////////////////////////////////////////////////////
+
+
+// SSE2 kernels
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef SCAN_X86
+
+namespace
+{
+    // Index of the lowest set bit, mask isn't 0
+    unsigned first_bit(unsigned mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // 0xFF in bytes which are digits
+    __m128i digits_sse2(__m128i v)
+    {
+        return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0'-1)),
+                             _mm_cmplt_epi8(v, _mm_set1_epi8('9'+1)));
+    }
+
+    const char *find_byte_sse2(const char *beg, const char *end, char a)
+    {
+        const __m128i va = _mm_set1_epi8(a);
+        for (; end-beg >= 16; beg+=16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(beg));
+            unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, va));
+            if (mask) return beg + first_bit(mask);
+        }
+        return find_byte_scalar(beg, end, a);
+    }
+
+    const char *find_byte2_sse2(const char *beg, const char *end,
+                                char a, char b)
+    {
+        const __m128i va = _mm_set1_epi8(a);
+        const __m128i vb = _mm_set1_epi8(b);
+        for (; end-beg >= 16; beg+=16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(beg));
+            unsigned mask = _mm_movemask_epi8(
+                        _mm_or_si128(_mm_cmpeq_epi8(v, va),
+                                     _mm_cmpeq_epi8(v, vb)));
+            if (mask) return beg + first_bit(mask);
+        }
+        return find_byte2_scalar(beg, end, a, b);
+    }
+
+    // Compare first and last byte of marker in 16 positions at once,
+    // and check the middle only for candidates
+    const char *find_sse2(const char *beg, const char *end,
+                          const char *marker, size_t len)
+    {
+        if (len < 2) return len ? find_byte_sse2(beg, end, *marker) : beg;
+
+        const __m128i first = _mm_set1_epi8(marker[0]);
+        const __m128i last = _mm_set1_epi8(marker[len-1]);
+        for (; end-beg >= static_cast<ptrdiff_t>(16+len-1); beg+=16)
+        {
+            __m128i vf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(beg));
+            __m128i vl = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i *>(beg+len-1));
+            unsigned mask = _mm_movemask_epi8(
+                        _mm_and_si128(_mm_cmpeq_epi8(vf, first),
+                                      _mm_cmpeq_epi8(vl, last)));
+            for (; mask; mask &= mask-1)
+            {
+                const char *pos = beg + first_bit(mask);
+                if (!memcmp(pos+1, marker+1, len-2)) return pos;
+            }
+        }
+        return find_scalar(beg, end, marker, len);
+    }
+
+    const char *find_digit_sse2(const char *beg, const char *end)
+    {
+        for (; end-beg >= 16; beg+=16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(beg));
+            unsigned mask = _mm_movemask_epi8(digits_sse2(v));
+            if (mask) return beg + first_bit(mask);
+        }
+        return find_digit_scalar(beg, end);
+    }
+
+    const char *skip_digits_sse2(const char *beg, const char *end)
+    {
+        for (; end-beg >= 16; beg+=16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(beg));
+            unsigned mask = ~_mm_movemask_epi8(digits_sse2(v)) & 0xFFFF;
+            if (mask) return beg + first_bit(mask);
+        }
+        return skip_digits_scalar(beg, end);
+    }
+} // !namespace
+
+#endif // SCAN_X86
+
+// !SSE2 kernels
+///////////////////////////////////////////////////////////////////////////////
+
+
+// AVX2 kernels
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef SCAN_X86
+
+namespace
+{
+    SCAN_AVX2_TARGET
+    const char *find_byte_avx2(const char *beg, const char *end, char a)
+    {
+        const __m256i va = _mm256_set1_epi8(a);
+        for (; end-beg >= 32; beg+=32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(beg));
+            unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, va));
+            if (mask) return beg + first_bit(mask);
+        }
+        return find_byte_sse2(beg, end, a);
+    }
+
+    SCAN_AVX2_TARGET
+    const char *find_byte2_avx2(const char *beg, const char *end,
+                                char a, char b)
+    {
+        const __m256i va = _mm256_set1_epi8(a);
+        const __m256i vb = _mm256_set1_epi8(b);
+        for (; end-beg >= 32; beg+=32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(beg));
+            unsigned mask = _mm256_movemask_epi8(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, va),
+                                        _mm256_cmpeq_epi8(v, vb)));
+            if (mask) return beg + first_bit(mask);
+        }
+        return find_byte2_sse2(beg, end, a, b);
+    }
+
+    SCAN_AVX2_TARGET
+    const char *find_avx2(const char *beg, const char *end,
+                          const char *marker, size_t len)
+    {
+        if (len < 2) return len ? find_byte_avx2(beg, end, *marker) : beg;
+
+        const __m256i first = _mm256_set1_epi8(marker[0]);
+        const __m256i last = _mm256_set1_epi8(marker[len-1]);
+        for (; end-beg >= static_cast<ptrdiff_t>(32+len-1); beg+=32)
+        {
+            __m256i vf = _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(beg));
+            __m256i vl = _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(beg+len-1));
+            unsigned mask = _mm256_movemask_epi8(
+                        _mm256_and_si256(_mm256_cmpeq_epi8(vf, first),
+                                         _mm256_cmpeq_epi8(vl, last)));
+            for (; mask; mask &= mask-1)
+            {
+                const char *pos = beg + first_bit(mask);
+                if (!memcmp(pos+1, marker+1, len-2)) return pos;
+            }
+        }
+        return find_sse2(beg, end, marker, len);
+    }
+
+    SCAN_AVX2_TARGET
+    const char *find_digit_avx2(const char *beg, const char *end)
+    {
+        const __m256i lo = _mm256_set1_epi8('0'-1);
+        const __m256i hi = _mm256_set1_epi8('9'+1);
+        for (; end-beg >= 32; beg+=32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(beg));
+            unsigned mask = _mm256_movemask_epi8(
+                        _mm256_and_si256(_mm256_cmpgt_epi8(v, lo),
+                                         _mm256_cmpgt_epi8(hi, v)));
+            if (mask) return beg + first_bit(mask);
+        }
+        return find_digit_sse2(beg, end);
+    }
+} // !namespace
+
+#endif // SCAN_X86
+
+// !AVX2 kernels
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Runtime dispatch
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Kernels of one instruction set
+    struct kernels
+    {
+        const char *name;
+        const char *(*find_byte)(const char *, const char *, char);
+        const char *(*find_byte2)(const char *, const char *, char, char);
+        const char *(*find)(const char *, const char *, const char *, size_t);
+        const char *(*find_digit)(const char *, const char *);
+        const char *(*skip_digits)(const char *, const char *);
+    };
+
+    // What processor supports
+    kernels detect()
+    {
+        kernels scalar = { "scalar", find_byte_scalar, find_byte2_scalar,
+                           find_scalar, find_digit_scalar, skip_digits_scalar };
+#ifdef SCAN_X86
+        kernels sse2 = { "sse2", find_byte_sse2, find_byte2_sse2,
+                         find_sse2, find_digit_sse2, skip_digits_sse2 };
+        kernels avx2 = { "avx2", find_byte_avx2, find_byte2_avx2,
+                         find_avx2, find_digit_avx2, skip_digits_sse2 };
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        bool has_sse2 = (info[3] & (1<<26)) != 0;
+        // AVX state must be saved by OS
+        bool has_avx = (info[2] & (1<<27)) && (info[2] & (1<<28))
+                && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        bool has_avx2 = has_avx && (info[1] & (1<<5));
+#else
+        __builtin_cpu_init();
+        bool has_sse2 = __builtin_cpu_supports("sse2");
+        bool has_avx2 = __builtin_cpu_supports("avx2");
+#endif
+        if (has_avx2) return avx2;
+        if (has_sse2) return sse2;
+#endif // SCAN_X86
+        return scalar;
+    }
+
+    // Chosen once, before main()
+    const kernels chosen = detect();
+} // !namespace
+
+// !Runtime dispatch
+///////////////////////////////////////////////////////////////////////////////
+
+
+// scan functions
+///////////////////////////////////////////////////////////////////////////////
+
+// First byte equal to a, or end
+const char *scan::find_byte(const char *beg, const char *end, char a)
+{
+    return chosen.find_byte(beg, end, a);
+} // !const char *scan::find_byte(...)
+
+// First byte equal to a or b, or end
+const char *scan::find_byte2(const char *beg, const char *end, char a, char b)
+{
+    return chosen.find_byte2(beg, end, a, b);
+} // !const char *scan::find_byte2(...)
+
+// First occurrence of marker, or end
+const char *scan::find(const char *beg, const char *end,
+                       const char *marker, size_t len)
+{
+    if (static_cast<size_t>(end-beg) < len) return end;
+    return chosen.find(beg, end, marker, len);
+} // !const char *scan::find(...)
+
+// Last occurrence of marker in [beg, end), or end
+const char *scan::rfind(const char *beg, const char *end,
+                        const char *marker, size_t len)
+{
+    if (static_cast<size_t>(end-beg) < len) return end;
+    for (const char *pos = end-len+1; pos-- != beg; )
+    {
+        if (*pos == *marker && !memcmp(pos, marker, len)) return pos;
+    }
+    return end;
+} // !const char *scan::rfind(...)
+
+// First digit, or end
+const char *scan::find_digit(const char *beg, const char *end)
+{
+    return chosen.find_digit(beg, end);
+} // !const char *scan::find_digit(...)
+
+// Read decimal number at beg and return pointer after its digits
+const char *scan::parse_digits(const char *beg, const char *end,
+                               unsigned long long &out)
+{
+    const char *digits_end = chosen.skip_digits(beg, end);
+    out = 0;
+    for (; beg != digits_end; ++beg) out = out*10 + (*beg-'0');
+    return digits_end;
+} // !const char *scan::parse_digits(...)
+
+// Name of chosen kernels: "avx2", "sse2" or "scalar"
+const char *scan::kernel_name()
+{
+    return chosen.name;
+} // !const char *scan::kernel_name()
+
+// !scan functions
+///////////////////////////////////////////////////////////////////////////////
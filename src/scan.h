@@ -0,0 +1,44 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// size_t
+#include <cstddef>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Vectorized search in html
+// AVX2, SSE2 or scalar kernels are chosen once at runtime,
+// by what the processor supports.
+namespace scan
+{
+    // First byte equal to a, or end
+    const char *find_byte(const char *beg, const char *end, char a);
+
+    // First byte equal to a or b, or end
+    const char *find_byte2(const char *beg, const char *end, char a, char b);
+
+    // First occurrence of marker, or end
+    const char *find(const char *beg, const char *end,
+                     const char *marker, size_t len);
+
+    // Last occurrence of marker in [beg, end), or end
+    // This is for rare backward searches, so it is scalar
+    const char *rfind(const char *beg, const char *end,
+                      const char *marker, size_t len);
+
+    // First digit, or end
+    const char *find_digit(const char *beg, const char *end);
+
+    // Read decimal number at beg and return pointer after its digits
+    const char *parse_digits(const char *beg, const char *end,
+                             unsigned long long &out);
+
+    // Name of chosen kernels: "avx2", "sse2" or "scalar"
+    const char *kernel_name();
+} // !namespace scan
+
+#endif // SCAN_H
@@ -0,0 +1,170 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "settings.h"
+
+// Default number of threads
+#include <thread>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// request_template Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Split text on placeholders
+request_template::request_template(const std::string &text,
+                                   std::initializer_list<const char *> names):
+    text(text),
+    literal_len(0)
+{
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        // The nearest placeholder
+        size_t found = text.npos;
+        size_t found_len = 0;
+        int found_value = -1;
+        int value = 0;
+        for (const char *name : names)
+        {
+            size_t at = text.find(name, pos);
+            if (at < found)
+            {
+                found = at;
+                found_len = std::char_traits<char>::length(name);
+                found_value = value;
+            }
+            ++value;
+        }
+
+        const size_t literal_end = found == text.npos ? text.size() : found;
+        if (literal_end > pos)
+        {
+            segment literal = { pos, literal_end-pos, -1 };
+            segments.push_back(literal);
+            literal_len += literal.size;
+        }
+        if (found == text.npos) break;
+
+        segment placeholder = { found, found_len, found_value };
+        segments.push_back(placeholder);
+        pos = found + found_len;
+    }
+} // !request_template::request_template(...)
+
+// Write request with values of placeholders to out
+void request_template::render(std::string &out,
+                              std::initializer_list<boost::string_ref> values)
+                              const
+{
+    size_t size = literal_len;
+    for (const segment &seg : segments)
+    {
+        if (seg.value >= 0 && static_cast<size_t>(seg.value) < values.size())
+            size += values.begin()[seg.value].size();
+    }
+
+    out.clear();
+    out.reserve(size);
+    for (const segment &seg : segments)
+    {
+        if (seg.value < 0)
+        {
+            out.append(text, seg.beg, seg.size);
+        }
+        else if (static_cast<size_t>(seg.value) < values.size())
+        {
+            const boost::string_ref &value = values.begin()[seg.value];
+            out.append(value.data(), value.size());
+        }
+    }
+} // !void request_template::render(...) const
+
+// !request_template Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// decimal Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+decimal::decimal(unsigned long long number):
+    beg(sizeof(digits))
+{
+    do
+    {
+        digits[--beg] = static_cast<char>('0' + number%10);
+        number /= 10;
+    } while (number);
+} // !decimal::decimal(...)
+
+// !decimal Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// settings Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Read settings, missing optional values are default
+settings::settings(const boost::property_tree::ptree &pref):
+    version(0)
+{
+    site.addr = pref.get<std::string>("pref.site.addr");
+    site.port = pref.get<std::string>("pref.site.port");
+    site.dns_ttl = std::chrono::seconds(
+                pref.get<size_t>("pref.site.dns_ttl", 300));
+    site.max_conn = pref.get<size_t>("pref.site.max_conn", 4);
+    site.idle_timeout = std::chrono::seconds(
+                pref.get<size_t>("pref.site.idle_timeout", 60));
+    site.warm_conn = pref.get<size_t>("pref.site.warm_conn", 1);
+
+    tasks.threads = pref.get<size_t>("pref.tasks.threads",
+                                     std::thread::hardware_concurrency());
+    tasks.deadline = std::chrono::seconds(
+                pref.get<size_t>("pref.tasks.deadline", 0));
+
+    metrics.file = pref.get<std::string>("pref.metrics.file", "");
+    metrics.port = pref.get<unsigned short>("pref.metrics.port", 0);
+
+    record.dir = pref.get<std::string>("pref.record.dir", "");
+
+    lists.batch_size = pref.get<size_t>("pref.lists.batch_size", 4096);
+    lists.batch_delay = std::chrono::milliseconds(
+                pref.get<size_t>("pref.lists.batch_delay", 200));
+
+    auth.get = request_template(pref.get<std::string>("pref.auth.GET"),
+                                {"$Content-Length"});
+    auth.post = request_template(pref.get<std::string>("pref.auth.POST"),
+                                 {"$login", "$password"});
+    auth.user_id = pref.get<std::string>("pref.auth.user_id");
+    auth.user_hash = pref.get<std::string>("pref.auth.user_hash");
+    auth.phpsid = pref.get<std::string>("pref.auth.PHPSID");
+
+    unread.get = request_template(pref.get<std::string>("pref.unread.GET"),
+                                  {"$Cookie", "$pagenumber"});
+    unread.num = pref.get<size_t>("pref.unread.num");
+    unread.start_page = pref.get<size_t>("pref.unread.start_page");
+    // 1 - one by one
+    unread.parallel = pref.get<size_t>("pref.unread.parallel", 1);
+    if (!unread.parallel) unread.parallel = 1;
+    unread.resume_ttl = pref.get<std::time_t>("pref.unread.resume_ttl", 600);
+
+    book_info.get = request_template(
+                pref.get<std::string>("pref.book_info.GET"), {"$id"});
+    // A week
+    book_info.cache_ttl =
+            pref.get<std::time_t>("pref.book_info.cache_ttl", 604800);
+    book_info.cache_size =
+            pref.get<size_t>("pref.book_info.cache_size", 16 << 20);
+    book_info.prefetch_first =
+            pref.get<size_t>("pref.book_info.prefetch_first", 5);
+    book_info.prefetch_near =
+            pref.get<size_t>("pref.book_info.prefetch_near", 2);
+    book_info.prefetch_parallel =
+            pref.get<size_t>("pref.book_info.prefetch_parallel", 2);
+} // !settings::settings(...)
+
+// !settings Public functions
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,161 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Values of settings
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctime>
+// Names and values of placeholders
+#include <initializer_list>
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Settings are read from XML once
+#include <boost/property_tree/ptree.hpp>
+// Values of placeholders without copy
+#include <boost/utility/string_ref.hpp>
+
+#endif // Q_MOC_RUN
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Request from pref.xml, split on its placeholders once
+// Rendering is one pass over segments into a reused buffer,
+// without search, replace and allocation.
+class request_template
+{
+public:
+    request_template(): literal_len(0) {}
+
+    // Split text on placeholders, value i of render() goes to names[i]
+    // Every occurrence of placeholder is replaced
+    request_template(const std::string &text,
+                     std::initializer_list<const char *> names);
+
+    // Write request with values of placeholders to out
+    // out isn't allocated, if its capacity is enough
+    void render(std::string &out,
+                std::initializer_list<boost::string_ref> values =
+                        std::initializer_list<boost::string_ref>()) const;
+
+private:
+    // Literal text[beg, beg+size) or placeholder
+    struct segment
+    {
+        size_t beg;
+        size_t size;
+        // Number of placeholder's value, -1 for literal
+        int value;
+    };
+
+private:
+    std::string text;
+    std::vector<segment> segments;
+    // Size of request without values
+    size_t literal_len;
+}; // !class request_template
+
+// Decimal text of number in own buffer, for request_template::render
+class decimal
+{
+public:
+    explicit decimal(unsigned long long number);
+
+    boost::string_ref str() const
+    { return boost::string_ref(digits+beg, sizeof(digits)-beg); }
+
+private:
+    char digits[20];
+    size_t beg;
+}; // !class decimal
+
+// Settings from $username.pref.xml, read once by engine::load_settings
+// Sections and names are the same as in XML.
+// Immutable after load, so tasks read it without locks.
+struct settings
+{
+    // Read settings, missing optional values are default
+    // Throw if required value or request is missing
+    explicit settings(const boost::property_tree::ptree &pref);
+
+    // Number of load or reload, which made this version
+    unsigned version;
+
+    struct
+    {
+        std::string addr;
+        std::string port;
+        std::chrono::seconds dns_ttl;
+        size_t max_conn;
+        std::chrono::seconds idle_timeout;
+        size_t warm_conn;
+    } site;
+
+    struct
+    {
+        size_t threads;
+        // 0 - no deadline
+        std::chrono::seconds deadline;
+    } tasks;
+
+    struct
+    {
+        std::string file;
+        // 0 - no stats endpoint
+        unsigned short port;
+    } metrics;
+
+    struct
+    {
+        // Empty - no recording
+        std::string dir;
+    } record;
+
+    struct
+    {
+        size_t batch_size;
+        std::chrono::milliseconds batch_delay;
+    } lists;
+
+    struct
+    {
+        // $Content-Length
+        request_template get;
+        // $login, $password
+        request_template post;
+        // Beginnings of cookies in reply
+        std::string user_id;
+        std::string user_hash;
+        std::string phpsid;
+    } auth;
+
+    struct
+    {
+        // $Cookie, $pagenumber
+        request_template get;
+        size_t num;
+        size_t start_page;
+        size_t parallel;
+        // Unfinished search goes on, if it started this long ago
+        std::time_t resume_ttl;
+    } unread;
+
+    struct
+    {
+        // $id
+        request_template get;
+        std::time_t cache_ttl;
+        size_t cache_size;
+        size_t prefetch_first;
+        size_t prefetch_near;
+        size_t prefetch_parallel;
+    } book_info;
+}; // !struct settings
+
+#endif // SETTINGS_H
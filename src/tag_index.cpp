@@ -0,0 +1,334 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tag_index.h"
+
+// Vectorized search of '<' and end of comments
+#include "scan.h"
+
+// lower_bound in selected elements
+#include <algorithm>
+// tolower
+#include <cctype>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Html helpers
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    bool is_space(char c)
+    {
+        return c==' ' || c=='\t' || c=='\r' || c=='\n' || c=='\f';
+    }
+
+    // End of tag or attribute name
+    bool is_name_end(char c)
+    {
+        return is_space(c) || c=='>' || c=='/' || c=='=';
+    }
+
+    // Elements without content and close tag
+    bool is_void(const std::string &name)
+    {
+        static const char *const void_tags[] =
+        {
+            "area", "base", "br", "col", "embed", "hr", "img", "input",
+            "link", "meta", "param", "source", "track", "wbr"
+        };
+        for (auto i : void_tags)
+        {
+            if (name == i) return true;
+        }
+        return false;
+    }
+
+    // Elements with raw text, where '<' isn't a tag
+    bool is_raw(const std::string &name)
+    {
+        return name == "script" || name == "style";
+    }
+
+    // Read name at pos in lower case, return position after it
+    const char *read_name(const char *pos, const char *end, std::string &name)
+    {
+        name.clear();
+        for (; pos != end && !is_name_end(*pos); ++pos)
+        {
+            name += static_cast<char>(tolower(static_cast<unsigned char>(*pos)));
+        }
+        return pos;
+    }
+} // !namespace
+
+// !Html helpers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// tag_index Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+tag_index::tag_index():
+    buf(nullptr)
+{
+} // !tag_index::tag_index()
+
+// Index html in [beg, end)
+void tag_index::build(const char *beg, const char *end)
+{
+    clear();
+    buf = beg;
+
+    for (const char *pos = scan::find_byte(beg, end, '<');
+         pos != end;
+         pos = scan::find_byte(pos, end, '<'))
+    {
+        if (end-pos < 2) break;
+
+        switch (pos[1])
+        {
+        case '!':
+        case '?':
+            // Comment may contain tags
+            if (pos[1]=='!' && end-pos >= 4 && pos[2]=='-' && pos[3]=='-')
+            {
+                pos = scan::find(pos+4, end, "-->", 3);
+                pos = pos == end ? end : pos+3;
+                break;
+            }
+            // <!DOCTYPE ...> and <?...> are skipped up to '>'
+            pos = scan::find_byte(pos, end, '>');
+            if (pos != end) ++pos;
+            break;
+        case '/':
+            pos = close_tag(pos, end);
+            break;
+        default:
+            pos = open_tag(pos, end);
+            break;
+        }
+    } // !for (...)
+
+    // Elements not closed till the end
+    close_to(0, end-beg, end-beg);
+} // !void tag_index::build(...)
+
+// Forget everything
+void tag_index::clear()
+{
+    buf = nullptr;
+    elements.clear();
+    stack.clear();
+    // Keep buckets and vectors for the next page
+    for (auto &i : selectors) i.second.clear();
+} // !void tag_index::clear()
+
+// First element with tag and class at or after offset, or npos
+// Elements of selector are in document order, offset is searched
+size_t tag_index::find(const char *tag, const char *cls, size_t offset) const
+{
+    const std::vector<size_t> *sel = selected(tag, cls);
+    if (!sel) return npos;
+
+    auto it = std::lower_bound(sel->begin(), sel->end(), offset,
+                               [this](size_t i, size_t offset)
+    {
+        return elements[i].open_beg < offset;
+    });
+    return it == sel->end() ? npos : *it;
+} // !size_t tag_index::find(...)
+
+// Last element with tag and class which begins before offset, or npos
+size_t tag_index::rfind(const char *tag, const char *cls, size_t offset) const
+{
+    const std::vector<size_t> *sel = selected(tag, cls);
+    if (!sel) return npos;
+
+    auto it = std::lower_bound(sel->begin(), sel->end(), offset,
+                               [this](size_t i, size_t offset)
+    {
+        return elements[i].open_beg < offset;
+    });
+    return it == sel->begin() ? npos : *--it;
+} // !size_t tag_index::rfind(...)
+
+// !tag_index Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// tag_index Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Parse open tag at pos, return position after its '>'
+const char *tag_index::open_tag(const char *pos, const char *end)
+{
+    const char *tag_beg = pos;
+    pos = read_name(pos+1, end, name);
+    // "<" followed by space or digit is just text
+    if (name.empty()) return tag_beg+1;
+
+    const size_t i = elements.size();
+    bool self_closed = false;
+
+    // Attributes up to '>', value in quotes may contain '>'
+    while (pos != end && *pos != '>')
+    {
+        if (is_space(*pos)) { ++pos; continue; }
+        if (*pos == '/') { self_closed = true; ++pos; continue; }
+        self_closed = false;
+
+        pos = read_name(pos, end, attr);
+        while (pos != end && is_space(*pos)) ++pos;
+        if (pos == end || *pos != '=')
+        {
+            if (attr.empty() && pos != end && *pos != '>') ++pos;
+            continue;
+        }
+        ++pos;
+        while (pos != end && is_space(*pos)) ++pos;
+        if (pos == end) break;
+
+        const char *value_beg = pos;
+        const char *value_end;
+        if (*pos == '"' || *pos == '\'')
+        {
+            value_beg = pos+1;
+            value_end = scan::find_byte(value_beg, end, *pos);
+            pos = value_end == end ? end : value_end+1;
+        }
+        else
+        {
+            while (pos != end && !is_space(*pos) && *pos != '>') ++pos;
+            value_end = pos;
+        }
+
+        // Every class is a selector
+        if (attr == "class")
+        {
+            for (const char *cls = value_beg; cls != value_end; )
+            {
+                if (is_space(*cls)) { ++cls; continue; }
+                const char *cls_end = cls;
+                while (cls_end != value_end && !is_space(*cls_end)) ++cls_end;
+                add_selector(cls, cls_end-cls, i);
+                cls = cls_end;
+            }
+        }
+    } // !while (...)
+    if (pos != end) ++pos;
+
+    element el;
+    el.open_beg = tag_beg-buf;
+    el.open_end = pos-buf;
+    el.close_beg = el.open_end;
+    el.close_end = el.open_end;
+    el.depth = static_cast<unsigned>(stack.size());
+    elements.push_back(el);
+    add_selector(nullptr, 0, i);
+
+    if (self_closed || is_void(name)) return pos;
+
+    // Content is text up to close tag
+    if (is_raw(name))
+    {
+        // "</" and name
+        const ptrdiff_t close_size = 2 + name.size();
+        const char *close_pos = pos;
+        for (;;)
+        {
+            close_pos = scan::find_byte(close_pos, end, '<');
+            if (end-close_pos < close_size)
+            {
+                close_pos = end;
+                break;
+            }
+            if (close_pos[1] == '/')
+            {
+                read_name(close_pos+2, end, attr);
+                if (attr == name) break;
+            }
+            ++close_pos;
+        }
+        const char *close_end = scan::find_byte(close_pos, end, '>');
+        if (close_end != end) ++close_end;
+        elements[i].close_beg = close_pos-buf;
+        elements[i].close_end = close_end-buf;
+        return close_end;
+    }
+
+    if (names.size() == stack.size()) names.push_back(name);
+    else names[stack.size()] = name;
+    stack.push_back(i);
+    return pos;
+} // !const char *tag_index::open_tag(...)
+
+// Parse close tag at pos, return position after its '>'
+const char *tag_index::close_tag(const char *pos, const char *end)
+{
+    const char *tag_beg = pos;
+    pos = read_name(pos+2, end, name);
+    pos = scan::find_byte(pos, end, '>');
+    if (pos != end) ++pos;
+
+    // Close the nearest open element with the name,
+    // and all elements inside it without close tags
+    for (size_t depth = stack.size(); depth--; )
+    {
+        if (names[depth] == name)
+        {
+            close_to(depth+1, tag_beg-buf, tag_beg-buf);
+            close_to(depth, tag_beg-buf, pos-buf);
+            break;
+        }
+    }
+    // Close tag without open one is ignored
+    return pos;
+} // !const char *tag_index::close_tag(...)
+
+// Close elements in stack down to depth at pos
+void tag_index::close_to(size_t depth, size_t close_beg, size_t close_end)
+{
+    while (stack.size() > depth)
+    {
+        element &el = elements[stack.back()];
+        el.close_beg = close_beg;
+        el.close_end = close_end;
+        stack.pop_back();
+    }
+} // !void tag_index::close_to(...)
+
+// Add element to selectors "tag" and "tag.class"
+// Tag is in name
+void tag_index::add_selector(const char *cls, size_t size, size_t i)
+{
+    key = name;
+    if (cls)
+    {
+        key += '.';
+        key.append(cls, size);
+    }
+    std::vector<size_t> &sel = selectors[key];
+    // The same class twice in one element
+    if (sel.empty() || sel.back() != i) sel.push_back(i);
+} // !void tag_index::add_selector(...)
+
+// Elements with selector
+const std::vector<size_t> *tag_index::selected(const char *tag,
+                                               const char *cls) const
+{
+    key = tag;
+    if (cls && *cls)
+    {
+        key += '.';
+        key += cls;
+    }
+    auto it = selectors.find(key);
+    return it == selectors.end() ? nullptr : &it->second;
+} // !const std::vector<size_t> *tag_index::selected(...)
+
+// !tag_index Private functions
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,110 @@
+#ifndef TAG_INDEX_H
+#define TAG_INDEX_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Elements in document order
+#include <vector>
+// Selector - elements with it
+#include <unordered_map>
+#include <string>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Index of html elements, made in one pass over the buffer
+// Only offsets are stored, so buffer must live while index is used.
+// Elements are selected by tag and class, like "span" + "fn":
+// one hash lookup gives elements with selector, and binary search
+// among them gives position, O(log k) for k such elements.
+class tag_index
+{
+public:
+    // Html element: offsets are relative to beginning of buffer
+    struct element
+    {
+        // '<' of open tag and position after its '>'
+        size_t open_beg;
+        size_t open_end;
+        // '<' of close tag and position after its '>'
+        // Equal to open_end if element has no content (<br>, <img/>)
+        // or to the position where it was closed implicitly
+        size_t close_beg;
+        size_t close_end;
+        // Nesting depth, 0 for top elements
+        unsigned depth;
+    };
+
+    static const size_t npos = static_cast<size_t>(-1);
+
+public:
+    tag_index();
+
+    // Index html in [beg, end)
+    void build(const char *beg, const char *end);
+
+    // Forget everything
+    void clear();
+
+    // First element with tag and class at or after offset, or npos
+    // Empty class means any element with tag
+    // Hash lookup and binary search among elements with selector
+    size_t find(const char *tag, const char *cls, size_t offset = 0) const;
+
+    // Last element with tag and class which begins before offset, or npos
+    size_t rfind(const char *tag, const char *cls, size_t offset) const;
+
+    const element &operator[](size_t i) const { return elements[i]; }
+
+    size_t size() const { return elements.size(); }
+
+    // Content of element without its tags
+    const char *inner_beg(size_t i) const { return buf+elements[i].open_end; }
+    size_t inner_size(size_t i) const
+    { return elements[i].close_beg - elements[i].open_end; }
+
+    // Element with its tags
+    const char *outer_beg(size_t i) const { return buf+elements[i].open_beg; }
+    size_t outer_size(size_t i) const
+    { return elements[i].close_end - elements[i].open_beg; }
+
+private:
+    // Parse open tag at pos, return position after its '>'
+    const char *open_tag(const char *pos, const char *end);
+
+    // Parse close tag at pos, return position after its '>'
+    const char *close_tag(const char *pos, const char *end);
+
+    // Close elements in stack down to depth at pos
+    void close_to(size_t depth, size_t close_beg, size_t close_end);
+
+    // Add element to selectors "tag" and "tag.class"
+    void add_selector(const char *cls, size_t size, size_t i);
+
+    // Elements with selector
+    const std::vector<size_t> *selected(const char *tag, const char *cls) const;
+
+private:
+    // Indexed buffer
+    const char *buf;
+
+    std::vector<element> elements;
+
+    // Open elements while building and their names in lower case
+    // names isn't shrunk with stack, so its strings keep capacity
+    std::vector<size_t> stack;
+    std::vector<std::string> names;
+
+    // "tag" or "tag.class" - elements in document order
+    std::unordered_map<std::string, std::vector<size_t>> selectors;
+
+    // Tag and attribute being parsed, and selector being looked up
+    // They are reused for every tag instead of allocated,
+    // so index isn't used by two threads at once
+    std::string name;
+    std::string attr;
+    mutable std::string key;
+}; // !class tag_index
+
+#endif // TAG_INDEX_H
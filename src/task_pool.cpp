@@ -0,0 +1,136 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "task_pool.h"
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// task_pool Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+task_pool::task_pool(boost::asio::io_service &io_service):
+    io_service(io_service),
+    running(0)
+{
+} // !task_pool::task_pool(...)
+
+//
+task_pool::~task_pool()
+{
+    stop();
+} // !task_pool::~task_pool()
+
+// Run io_service on num threads
+void task_pool::start(size_t num)
+{
+    if (!num) num = 1;
+    if (num == threads.size()) return;
+
+    stop();
+
+    io_service.reset();
+    work.reset(new boost::asio::io_service::work(io_service));
+    for (size_t i(0); i < num; ++i)
+    {
+        threads.emplace_back([this]()
+        {
+            io_service.run();
+        });
+    }
+} // !void task_pool::start(...)
+
+// Stop all threads, queued tasks remain in io_service
+void task_pool::stop()
+{
+    if (threads.empty()) return;
+
+    work.reset();
+    io_service.stop();
+    for (auto &i : threads) i.join();
+    threads.clear();
+} // !void task_pool::stop()
+
+// Run task on pool, its exception is passed to wait_all(...)
+void task_pool::post(task t)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++running;
+    }
+    io_service.post([this, t]()
+    {
+        try
+        {
+            t();
+        }
+        catch (...)
+        {
+            finish(std::current_exception());
+            return;
+        }
+        finish(std::exception_ptr());
+    });
+} // !void task_pool::post(...)
+
+// Wait until all posted tasks and sub-tasks are finished
+void task_pool::wait_all(const result_handler &on_result)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        while (results.size())
+        {
+            std::exception_ptr error = results.front();
+            results.pop_front();
+            size_t remain = running + results.size();
+
+            lock.unlock();
+            on_result(remain, error);
+            lock.lock();
+        }
+        if (!running) break;
+        finished.wait(lock);
+    }
+} // !void task_pool::wait_all(...)
+
+// !task_pool Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// task_pool Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Task or sub-task is finished, with or without exception
+void task_pool::finish(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    --running;
+    if (error)
+    {
+        if (results.size() >= max_results) results.pop_front();
+        results.push_back(error);
+    }
+    finished.notify_all();
+} // !void task_pool::finish(...)
+
+// Run the oldest queued sub-task on this thread
+bool task_pool::run_sub_task()
+{
+    task t;
+    {
+        std::lock_guard<std::mutex> lock(sub_mutex);
+        if (sub_tasks.empty()) return false;
+        t = std::move(sub_tasks.front());
+        sub_tasks.pop_front();
+    }
+    // Exception is kept in sub-task's future
+    t();
+    finish(std::exception_ptr());
+    return true;
+} // !bool task_pool::run_sub_task()
+
+// !task_pool Private functions
+///////////////////////////////////////////////////////////////////////////////
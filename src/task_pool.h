@@ -0,0 +1,159 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Worker threads and waiting for them
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+// Sub-tasks return result through future
+#include <future>
+// Task's exceptions, kept until wait_all(...)
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+
+// Qt MOC conflicts with boost
+#ifndef Q_MOC_RUN
+
+// Network:
+#include <boost/asio.hpp>
+
+#endif // Q_MOC_RUN
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Fixed number of threads running io_service
+// Tasks are posted as io_service handlers. The end of every task is
+// reported to waiting thread by condition variable, not found by polling.
+// Sub-tasks wait in own queue, so task waiting for them runs only them,
+// not other tasks of pool.
+class task_pool
+{
+public:
+    typedef std::function<void ()> task;
+
+    // Called for every failed task with number of remaining tasks
+    // and task's exception
+    typedef std::function<void (size_t remain,
+                                std::exception_ptr error)> result_handler;
+
+public:
+    explicit task_pool(boost::asio::io_service &io_service);
+
+    ~task_pool();
+
+    // Run io_service on num threads
+    // Tasks must be finished, if number of threads is changed
+    void start(size_t num);
+
+    // Stop all threads, queued tasks remain in io_service
+    void stop();
+
+    // Number of running threads
+    size_t size() const { return threads.size(); }
+
+    // Run task on pool, its exception is passed to wait_all(...)
+    void post(task t);
+
+    // Run sub-task on pool, its result and exception are in future
+    // Sub-task must not wait for other sub-tasks
+    template <typename Func>
+    auto submit(Func f) -> std::future<decltype(f())>;
+
+    // Get result of sub-task
+    // Queued sub-tasks are run meanwhile, so it is safe to call from task
+    template <typename T>
+    T get(std::future<T> &f);
+
+    // Wait until all posted tasks and sub-tasks are finished
+    // Exceptions of sub-tasks are in their futures, not passed here
+    void wait_all(const result_handler &on_result);
+
+private:
+    // Task or sub-task is finished, with or without exception
+    void finish(std::exception_ptr error);
+
+    // Run the oldest queued sub-task on this thread
+    // Return false if none is queued
+    bool run_sub_task();
+
+private:
+    boost::asio::io_service &io_service;
+
+    // Keeps io_service running while there is nothing to do
+    std::unique_ptr<boost::asio::io_service::work> work;
+
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    // Posted or submitted, but not finished tasks
+    size_t running;
+
+    // Exceptions of failed tasks, not passed to wait_all(...) yet
+    // Only the latest max_results are kept, wait_all(...) may be rare
+    std::deque<std::exception_ptr> results;
+    static const size_t max_results = 64;
+
+    // Submitted, but not started sub-tasks
+    // Every one has its handler in io_service, which may find it taken
+    std::mutex sub_mutex;
+    std::deque<task> sub_tasks;
+}; // !class task_pool
+
+
+// task_pool Template functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Run sub-task on pool, its result and exception are in future
+template <typename Func>
+auto task_pool::submit(Func f) -> std::future<decltype(f())>
+{
+    typedef decltype(f()) result_type;
+    // std::function needs copyable handler
+    auto pt = std::make_shared<std::packaged_task<result_type ()>>(std::move(f));
+    std::future<result_type> result = pt->get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++running;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sub_mutex);
+        sub_tasks.push_back([pt]()
+        {
+            (*pt)();
+        });
+    }
+    // Pool thread runs it, unless get(...) has done it before
+    io_service.post([this]()
+    {
+        run_sub_task();
+    });
+    return result;
+} // !auto task_pool::submit(...)
+
+// Get result of sub-task
+// Queued sub-tasks are run meanwhile, so it is safe to call from task
+template <typename T>
+T task_pool::get(std::future<T> &f)
+{
+    while (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        // Other tasks aren't run here, they would delay this one
+        // Nothing queued - sub-task is running on other thread
+        if (!run_sub_task()) f.wait();
+    }
+    return f.get();
+} // !T task_pool::get(...)
+
+// !task_pool Template functions
+///////////////////////////////////////////////////////////////////////////////
+
+#endif // TASK_POOL_H
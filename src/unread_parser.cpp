@@ -0,0 +1,164 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+#include "unread_parser.h"
+
+// Vectorized search of markers and digits
+#include "scan.h"
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Markers of listing
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Link to book's page
+    const char link_marker[] = "<a href=\"";
+    const size_t link_len = sizeof(link_marker)-1;
+
+    // Book isn't rated
+    const char rate_marker[] = "data-rate=\"\"";
+    const size_t rate_len = sizeof(rate_marker)-1;
+
+    bool is_space(char c)
+    {
+        return c==' ' || c=='\t' || c=='\r' || c=='\n';
+    }
+
+    // Markers have no repeated prefix,
+    // so on mismatch only the current byte has to be checked again
+    void match(const char *marker, size_t &matched, char c)
+    {
+        if (c == marker[matched]) ++matched;
+        else matched = c == marker[0];
+    }
+}
+
+// !Markers of listing
+///////////////////////////////////////////////////////////////////////////////
+
+
+// unread_parser Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+//
+unread_parser::unread_parser(book_handler on_book):
+    on_book(std::move(on_book))
+{
+    title.reserve(max_title);
+    reset();
+} // !unread_parser::unread_parser(...)
+
+// Forget everything and wait for new page
+void unread_parser::reset()
+{
+    state = st_scan;
+    link_match = 0;
+    rate_match = 0;
+    has_link = false;
+    id = 0;
+    title.clear();
+} // !void unread_parser::reset()
+
+// Parse next piece of page
+void unread_parser::feed(const char *data, size_t size)
+{
+    const char * const end = data+size;
+    while (data != end)
+    {
+        switch (state)
+        {
+        case st_scan:
+            // Nothing is matched, so jump to possible beginning of marker
+            if (!link_match && !rate_match)
+            {
+                data = scan::find_byte2(data, end, link_marker[0],
+                                        rate_marker[0]);
+                if (data == end) break;
+            }
+            match(link_marker, link_match, *data);
+            match(rate_marker, rate_match, *data);
+            ++data;
+            if (link_match == link_len)
+            {
+                link_match = 0;
+                rate_match = 0;
+                has_link = false;
+                id = 0;
+                title.clear();
+                state = st_id_skip;
+            }
+            else if (rate_match == rate_len)
+            {
+                link_match = 0;
+                rate_match = 0;
+                if (has_link) add_book();
+            }
+            break;
+        case st_id_skip:
+            data = scan::find_digit(data, end);
+            if (data != end) state = st_id;
+            break;
+        case st_id:
+        {
+            // Id may be split between pieces
+            unsigned long long part;
+            const char *digits_end = scan::parse_digits(data, end, part);
+            for (; data != digits_end; ++data) id*=10;
+            id+=part;
+            if (data == end) break;
+            state = *data == '>' ? st_title : st_tag_end;
+            ++data;
+            break;
+        }
+        case st_tag_end:
+            data = scan::find_byte(data, end, '>');
+            if (data == end) break;
+            state = st_title;
+            ++data;
+            break;
+        case st_title:
+        {
+            // Trim spaces at the beginning
+            if (title.empty())
+            {
+                while (data != end && is_space(*data)) ++data;
+                if (data == end) break;
+            }
+            const char *title_end = scan::find_byte(data, end, '<');
+            size_t size = title_end-data;
+            if (size > max_title-title.size()) size = max_title-title.size();
+            title.append(data, size);
+            data = title_end;
+            if (data == end) break;
+
+            // Trim spaces at the end
+            while (title.size() && is_space(title.back())) title.pop_back();
+            has_link = true;
+            // '<' may be the link itself
+            state = st_scan;
+            break;
+        }
+        }
+    } // !while (...)
+} // !void unread_parser::feed(...)
+
+// !unread_parser Public functions
+///////////////////////////////////////////////////////////////////////////////
+
+
+// unread_parser Private functions
+///////////////////////////////////////////////////////////////////////////////
+
+// Add last link to unread books
+void unread_parser::add_book()
+{
+    has_link = false;
+    on_book(id, title.data(), title.size());
+} // !void unread_parser::add_book()
+
+// !unread_parser Private functions
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,72 @@
+#ifndef UNREAD_PARSER_H
+#define UNREAD_PARSER_H
+
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Book is passed to user as soon as it is found
+#include <functional>
+// Title of the last link
+#include <string>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// Resumable tokenizer of rating listing
+// Page is fed piece by piece as it arrives, and only the last
+// book link is kept between pieces, so memory doesn't depend on page size.
+//
+// Book in listing looks like:
+//     <a href="http://books.imhonet.ru/element/123/"> Title </a>
+//     ... data-rate="" ...
+// Empty data-rate means the book is not rated yet.
+class unread_parser
+{
+public:
+    // Receives id and title (utf-8, without spaces around) of unread book
+    typedef std::function<void (unsigned long long id,
+                                const char *title, size_t size)> book_handler;
+
+public:
+    explicit unread_parser(book_handler on_book);
+
+    // Forget everything and wait for new page
+    void reset();
+
+    // Parse next piece of page
+    void feed(const char *data, size_t size);
+
+private:
+    // What is parsing now
+    enum parse_state
+    {
+        st_scan,     // Search for link or data-rate
+        st_id_skip,  // Skip to first digit of id in link
+        st_id,       // Digits of id
+        st_tag_end,  // Skip to end of <a ...>
+        st_title     // Title up to next tag
+    };
+
+    // Longer title is cut
+    static const size_t max_title = 1024;
+
+private:
+    // Add last link to unread books
+    void add_book();
+
+private:
+    book_handler on_book;
+
+    parse_state state;
+
+    // Matched bytes of "<a href=\"" and "data-rate=\"\""
+    size_t link_match;
+    size_t rate_match;
+
+    // The last link
+    bool has_link;
+    unsigned long long id;
+    std::string title;
+}; // !class unread_parser
+
+#endif // UNREAD_PARSER_H
@@ -0,0 +1,239 @@
+// Headers
+///////////////////////////////////////////////////////////////////////////////
+
+// request_line()
+#include "recorder.h"
+
+// Fixtures and output
+#include <iostream>
+#include <fstream>
+#include <sstream>
+// Request line - reply
+#include <map>
+#include <string>
+// Thread per connection
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// Network:
+#include <boost/asio.hpp>
+
+// !Headers
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Replay server
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    using boost::asio::ip::tcp;
+
+    // How replies are sent
+    struct link_settings
+    {
+        // Delay before the first byte of reply
+        std::chrono::milliseconds latency;
+        // Bytes per second, 0 - no limit
+        size_t bandwidth;
+        // Reply is written by pieces of this size, 0 - at once
+        size_t chunk;
+    };
+
+    // Request line - raw reply
+    typedef std::map<std::string, std::string> fixture_map;
+
+    // Load NNNNNN.rsp of every request line from index.txt
+    // The last recorded exchange of request line wins
+    bool load_fixtures(const std::string &dir, fixture_map &out_fixtures)
+    {
+        std::ifstream index(dir + "/index.txt");
+        if (!index) return false;
+
+        std::string line;
+        while (getline(index, line))
+        {
+            if (line.size() && line.back() == '\r') line.pop_back();
+            const size_t space = line.find(' ');
+            if (space == line.npos) continue;
+
+            std::ifstream rsp(dir + '/' + line.substr(0, space) + ".rsp",
+                              std::ios::binary);
+            if (!rsp) continue;
+            std::ostringstream reply;
+            reply << rsp.rdbuf();
+            out_fixtures[line.substr(space+1)] = reply.str();
+        }
+        return true;
+    }
+
+    // Reply asks to close connection
+    bool is_close(const std::string &reply)
+    {
+        std::string head = reply.substr(0, reply.find("\r\n\r\n"));
+        std::transform(head.begin(), head.end(), head.begin(), ::tolower);
+        return head.find("connection: close") != head.npos;
+    }
+
+    // Write reply by chunks with pauses, like slow link does
+    void send_reply(tcp::socket &socket, const std::string &reply,
+                    const link_settings &link)
+    {
+        std::this_thread::sleep_for(link.latency);
+
+        const size_t chunk = link.chunk ? link.chunk : reply.size();
+        for (size_t pos = 0; pos < reply.size(); pos += chunk)
+        {
+            const size_t size = std::min(chunk, reply.size()-pos);
+            boost::asio::write(socket,
+                               boost::asio::buffer(reply.data()+pos, size));
+            if (link.bandwidth)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(
+                        size*1000000/link.bandwidth));
+            }
+        }
+    }
+
+    // Serve keep-alive connection until client closes it
+    void serve(std::shared_ptr<tcp::socket> socket,
+               const fixture_map &fixtures, const link_settings &link)
+    {
+        static const std::string not_found =
+                "HTTP/1.1 404 Not Found\r\n"
+                "Content-Length: 0\r\n\r\n";
+        // Authorize isn't recorded, any POST gets cookies
+        // with names from default pref.xml and values of recorder
+        static const std::string authorized =
+                "HTTP/1.1 200 OK\r\n"
+                "Set-Cookie: _user_id=replay; path=/\r\n"
+                "Set-Cookie: _user_hash=replay; path=/\r\n"
+                "Set-Cookie: PHPSESSID=replay; path=/\r\n"
+                "Content-Length: 0\r\n\r\n";
+
+        boost::system::error_code ec;
+        boost::asio::streambuf buf;
+        for (;;)
+        {
+            // Head up to empty line
+            // Requests from pref.xml end lines with \n only
+            // and may have extra empty lines after them
+            std::string head;
+            for (std::string line; line != "\n" && line != "\r\n"; )
+            {
+                const size_t size = boost::asio::read_until(*socket, buf,
+                                                            '\n', ec);
+                if (ec) return;
+                line.assign(boost::asio::buffers_begin(buf.data()),
+                            boost::asio::buffers_begin(buf.data())+size);
+                buf.consume(size);
+                if (head.empty() && (line == "\n" || line == "\r\n"))
+                {
+                    line.clear();
+                    continue;
+                }
+                head += line;
+            }
+
+            // and body of POST
+            std::string lower(head);
+            std::transform(lower.begin(), lower.end(), lower.begin(),
+                           ::tolower);
+            const size_t len_pos = lower.find("content-length:");
+            if (len_pos != lower.npos)
+            {
+                const size_t len = std::strtoul(
+                            head.c_str()+len_pos+strlen("content-length:"),
+                            nullptr, 10);
+                if (buf.size() < len)
+                {
+                    boost::asio::read(*socket, buf,
+                                      boost::asio::transfer_exactly(
+                                          len-buf.size()), ec);
+                    if (ec) return;
+                }
+                buf.consume(len);
+            }
+
+            const std::string line = request_line(head);
+            auto found = fixtures.find(line);
+            const bool post = !line.compare(0, 5, "POST ");
+            std::cout << (found != fixtures.end() || post ? "200 " : "404 ")
+                      << line << std::endl;
+
+            try
+            {
+                if (found == fixtures.end())
+                {
+                    send_reply(*socket, post ? authorized : not_found, link);
+                    continue;
+                }
+                send_reply(*socket, found->second, link);
+            }
+            catch (boost::system::system_error &)
+            {
+                return;
+            }
+            if (is_close(found->second)) return;
+        }
+    }
+} // !namespace
+
+// !Replay server
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Usage: replay dir [port] [latency_ms] [bytes_per_sec] [chunk_bytes]
+// dir is pref.record.dir of recording session,
+// set pref.site.addr to 127.0.0.1 and pref.site.port to port
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: replay dir [port=8080] [latency_ms=0] "
+                     "[bytes_per_sec=0] [chunk_bytes=0]" << std::endl;
+        return 1;
+    }
+
+    fixture_map fixtures;
+    if (!load_fixtures(argv[1], fixtures))
+    {
+        std::cerr << "Can't read " << argv[1] << "/index.txt" << std::endl;
+        return 1;
+    }
+
+    const unsigned short port = static_cast<unsigned short>(
+                argc > 2 ? std::atoi(argv[2]) : 8080);
+    link_settings link;
+    link.latency = std::chrono::milliseconds(argc > 3 ? std::atoi(argv[3]) : 0);
+    link.bandwidth = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0;
+    link.chunk = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 0;
+
+    try
+    {
+        boost::asio::io_service io_service;
+        tcp::acceptor acceptor(io_service, tcp::endpoint(
+                    boost::asio::ip::address_v4::loopback(), port));
+
+        std::cout << "Replaying " << fixtures.size() << " exchanges on 127.0.0.1:"
+                  << port << std::endl;
+
+        for (;;)
+        {
+            auto socket = std::make_shared<tcp::socket>(io_service);
+            acceptor.accept(*socket);
+            socket->set_option(tcp::no_delay(true));
+            std::thread(serve, socket, std::cref(fixtures),
+                        std::cref(link)).detach();
+        }
+    }
+    catch (std::exception &ref)
+    {
+        std::cerr << ref.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Local stand-in for the site: replays recorded exchanges
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = replay
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+    main.cpp \
+    ../../src/recorder.cpp
+
+HEADERS  += \
+    ../../src/recorder.h
+
+INCLUDEPATH += ../../src
+
+INCLUDEPATH += D:\Code\boost_1_54_0
+LIBS += -LD:\Code\boost_1_54_0\stage\lib